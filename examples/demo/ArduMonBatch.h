@@ -0,0 +1,110 @@
+#ifndef AM_BATCH_H
+#define AM_BATCH_H
+
+/**
+ * ArduMon: Yet another Arduino serial command library.
+ *
+ * See https://github.com/martyvona/ArduMon/blob/main/README.md
+ *
+ * This demonstrates coalescing small outgoing command packets into one compound command packet in binary mode, like
+ * Nagle's algorithm, for a peer that sends many tiny messages, e.g. setters or notifications.
+ *
+ * Each packet costs a length byte and a checksum byte, and is sent and received separately.  Instead the producer can
+ * put() each complete packet, e.g. as encoded by the functions in demo_cmds.h, into an open batch, which is a
+ * compound command packet, see ArduMon::getCompoundHandler().  Each put() packet becomes one subcommand, i.e. a length
+ * byte followed by the command code and payload, so it costs one byte less than on its own and does not need to be
+ * sent and handled separately.  The batch is sent when the next packet would not fit, when tick() finds that its
+ * first packet was put more than max_delay_us ago, or when flush() is called.
+ *
+ * The receiver registers ArduMon::getCompoundHandler() with compound_code, which splits the batch and dispatches each
+ * subcommand to its usual handler.  By default the batch uses COMPOUND_NO_RESPONSE, so that nothing is sent back; then
+ * only commands whose responses are not needed should be batched.  Otherwise the responses are also collected into one
+ * compound response packet.
+ *
+ * Copyright 2025 Marsette A. Vona (martyvona@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+template <typename AM, uint8_t frame_sz = 64> class ArduMonBatch {
+public:
+
+  ArduMonBatch(const typename AM::cmd_code_t _compound_code, const unsigned long _max_delay_us = 2000,
+               const uint8_t _options = AM::COMPOUND_NO_RESPONSE)
+    : compound_code(_compound_code), max_delay_us(_max_delay_us), options(_options) {}
+
+  //append the complete packet, including its length and checksum bytes, to the batch, first sending the batch if the
+  //packet would not fit; returns false if that send failed, e.g. because the send buffer is busy, or if the packet
+  //would not fit even in an empty batch, in which case it should be sent on its own
+  bool put(AM &am, const char *packet) {
+    const uint8_t len = static_cast<uint8_t>(packet[0]);
+    if (len < 3 || len - 1 > frame_sz - header()) return false; //subcommand length byte replaces the packet's two
+    if (num_records > 0 && end + len > frame_sz && !flush(am)) return false; //len - 1 bytes plus the checksum
+    if (num_records == 0) {
+      end = 1; //the first byte is the length
+      if (AM::MAX_CMD_CODE > 0xff && compound_code >= 0x80) { //see AM::sendCode()
+        frame[end++] = static_cast<char>(0x80 | (compound_code >> 8));
+      }
+      frame[end++] = static_cast<char>(compound_code);
+      frame[end++] = static_cast<char>(options);
+      first_us = micros();
+    }
+    frame[end++] = static_cast<char>(len - 2);
+    memcpy(frame + end, packet + 1, len - 2);
+    end += len - 2;
+    ++num_records; ++total_records;
+    return true;
+  }
+
+  //send the batch now, if it is not empty; returns false if that failed, e.g. because the send buffer is busy
+  bool flush(AM &am) {
+    if (num_records == 0) return true;
+    if (am.isSendingPacket()) return false;
+    frame[0] = static_cast<char>(end + 1);
+    uint8_t sum = 0;
+    for (uint8_t i = 0; i < end; i++) sum += static_cast<uint8_t>(frame[i]);
+    frame[end] = static_cast<char>(-sum);
+    if (!am.sendFramed(frame)) return false;
+    num_records = 0; ++num_batches;
+    return true;
+  }
+
+  //send the batch if its first packet was put more than max_delay_us ago
+  //call this from the Arduino loop() method; returns true if the batch was sent
+  bool tick(AM &am) {
+    if (num_records == 0 || am.isHandling() || micros() - first_us < max_delay_us) return false;
+    return flush(am);
+  }
+
+  uint8_t getNumRecords() { return num_records; } //packets in the open batch
+
+  uint32_t getTotalRecords() { return total_records; } //packets ever put
+
+  uint32_t getNumBatches() { return num_batches; } //batches sent
+
+private:
+
+  //length byte, compound code, options, and reserved checksum byte
+  uint8_t header() { return 1 + (AM::MAX_CMD_CODE <= 0xff || compound_code < 0x80 ? 1 : 2) + 1 + 1; }
+
+  const typename AM::cmd_code_t compound_code;
+  const unsigned long max_delay_us;
+  const uint8_t options;
+
+  char frame[frame_sz];
+  uint8_t end = 0, num_records = 0; //end is the next free byte in frame
+  unsigned long first_us = 0; //micros() when the first packet of the open batch was put
+  uint32_t total_records = 0, num_batches = 0;
+};
+
+#endif //AM_BATCH_H
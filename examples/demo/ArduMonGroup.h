@@ -0,0 +1,116 @@
+#ifndef AM_GROUP_H
+#define AM_GROUP_H
+
+/**
+ * ArduMon: Yet another Arduino serial command library.
+ *
+ * See https://github.com/martyvona/ArduMon/blob/main/README.md
+ *
+ * This services several ArduMon instances from one Arduino loop(), e.g. one per serial interface, fairly.
+ *
+ * Each instance is added through the small ArduMonGroup::Member interface, so that instances with different template
+ * configurations can be in the same group; ArduMonGroup::Of<AM> adapts any ArduMon instance to it.  The instances
+ * are not copied, so they must outlive the group.
+ *
+ * ArduMonGroup::update() gives each member one update() per round, in round robin order, starting with a different
+ * member each round.  Each member can have a byte budget, which limits the number of bytes its update() receives, and
+ * a time budget in microseconds.  A member whose updates took longer than its time budget accumulates a deficit and is
+ * skipped in the following rounds until it is paid off at the rate of one time budget per round (deficit round
+ * robin), so a busy member, e.g. one receiving a flood of commands or running slow handlers, gets at most about its
+ * budget's share of the loop while the others are still serviced every round.
+ *
+ * hasPendingWork() and getNextDeadlineUS() combine those of the members, so that the caller can sleep, or do other
+ * work, until update() is due.
+ *
+ * Copyright 2025 Marsette A. Vona (martyvona@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+template <uint8_t max_members> class ArduMonGroup {
+public:
+
+  static const unsigned long NO_DEADLINE = -1; //all 1s as unsigned, same as ArduMon::NO_DEADLINE
+
+  //the interface through which the group services an ArduMon instance, independent of its template parameters
+  struct Member {
+    virtual void update(const uint16_t max_recv_bytes) = 0;
+    virtual bool hasPendingWork() = 0;
+    virtual unsigned long getNextDeadlineUS() = 0;
+    virtual ~Member() {}
+  };
+
+  //adapt an ArduMon instance to the Member interface
+  template <typename AM> struct Of : public Member {
+    AM &am; Of(AM &_am) : am(_am) {}
+    void update(const uint16_t max_recv_bytes) { am.update(max_recv_bytes); }
+    bool hasPendingWork() { return am.hasPendingWork(); }
+    unsigned long getNextDeadlineUS() { return am.getNextDeadlineUS(); }
+  };
+
+  //add a member with a byte budget per round and a time budget per round in microseconds, 0 for no limit
+  //returns false if there are already max_members
+  bool add(Member &m, const uint16_t max_recv_bytes = 0, const unsigned long budget_us = 0) {
+    if (num_members == max_members) return false;
+    Slot &s = slots[num_members++];
+    s.member = &m; s.max_recv_bytes = max_recv_bytes; s.budget_us = budget_us; s.deficit_us = 0;
+    return true;
+  }
+
+  uint8_t getNumMembers() { return num_members; }
+
+  //run one round: call update() on each member that is not paying off a deficit, see above
+  //call this from the Arduino loop() method; returns the number of members that were updated
+  uint8_t update() {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < num_members; i++) {
+      Slot &s = slots[(first + i) % num_members];
+      if (s.budget_us == 0) { s.member->update(s.max_recv_bytes); ++n; continue; }
+      if (s.deficit_us > 0) { s.deficit_us = s.deficit_us > s.budget_us ? s.deficit_us - s.budget_us : 0; continue; }
+      const unsigned long start = micros();
+      s.member->update(s.max_recv_bytes);
+      const unsigned long used = micros() - start;
+      if (used > s.budget_us) s.deficit_us = used - s.budget_us;
+      ++n;
+    }
+    if (num_members > 0) first = (first + 1) % num_members;
+    return n;
+  }
+
+  //check if any member has work to do right now, or is paying off a deficit and so will need more rounds
+  bool hasPendingWork() {
+    for (uint8_t i = 0; i < num_members; i++) {
+      if (slots[i].deficit_us > 0 || slots[i].member->hasPendingWork()) return true;
+    }
+    return false;
+  }
+
+  //the soonest getNextDeadlineUS() of the members, 0 if hasPendingWork(), NO_DEADLINE if nothing is scheduled
+  unsigned long getNextDeadlineUS() {
+    unsigned long us = NO_DEADLINE;
+    for (uint8_t i = 0; i < num_members && us > 0; i++) {
+      const unsigned long d = slots[i].deficit_us > 0 ? 0 : slots[i].member->getNextDeadlineUS();
+      if (d < us) us = d;
+    }
+    return us;
+  }
+
+private:
+
+  struct Slot { Member *member; uint16_t max_recv_bytes; unsigned long budget_us, deficit_us; };
+
+  Slot slots[max_members > 0 ? max_members : 1];
+  uint8_t num_members = 0, first = 0;
+};
+
+#endif //AM_GROUP_H
@@ -0,0 +1,244 @@
+#ifndef AM_OFFLOAD_H
+#define AM_OFFLOAD_H
+
+/**
+ * ArduMon: Yet another Arduino serial command library.
+ *
+ * See https://github.com/martyvona/ArduMon/blob/main/README.md
+ *
+ * This demonstrates offloading slow binary mode commands to worker threads so that they do not block ArduMon::update().
+ *
+ * A command is made offloadable by registering an ArduMonOffload::Cmd for it, which wraps a work function instead of
+ * a handler.  When the command is received the Cmd copies the packet payload following the command code into a free
+ * Job slot, queues it for the workers, and ends the handler right away, so the next command can be received while
+ * the work runs.  The work function runs on a worker thread with only the Job, which it reads arguments from and
+ * writes its response to; it must not call ArduMon.  ArduMonOffload::tick() then sends the responses of finished jobs
+ * back on the ArduMon thread, each in its own packet starting with the command code.  Responses of different commands
+ * can thus be sent in a different order than the commands were received.
+ *
+ * Workers are std::threads in native builds and FreeRTOS tasks on ESP32.  On other platforms, or if all job slots are
+ * busy, the work function runs immediately in the handler, which gives the same responses without the concurrency.
+ *
+ * Offloaded commands are not supported in text mode, where their handler fails.
+ *
+ * Copyright 2025 Marsette A. Vona (martyvona@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if defined(ESP32)
+#define AM_OFFLOAD_FREERTOS
+#elif !defined(ARDUINO)
+#define AM_OFFLOAD_THREADS
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+template <typename AM, uint8_t num_workers = 2, uint8_t max_jobs = 4, uint8_t max_job_bytes = 32>
+class ArduMonOffload {
+public:
+
+  //the payload of a received command packet after its code, and the payload of the response packet after its code
+  struct Job {
+
+    uint8_t in[max_job_bytes], out[max_job_bytes];
+    uint8_t in_len = 0, out_len = 0, in_pos = 0;
+
+    //read the next little endian value from in; returns false if there are not sizeof(T) bytes remaining
+    template <typename T> bool get(T &v) {
+      if (static_cast<size_t>(in_len - in_pos) < sizeof(T)) return false;
+      memcpy(&v, in + in_pos, sizeof(T)); in_pos += sizeof(T);
+      return true;
+    }
+
+    //append a little endian value to out; returns false if it does not fit
+    template <typename T> bool put(const T &v) {
+      if (static_cast<size_t>(max_job_bytes - out_len) < sizeof(T)) return false;
+      memcpy(out + out_len, &v, sizeof(T)); out_len += sizeof(T);
+      return true;
+    }
+
+  private:
+    friend class ArduMonOffload;
+    enum class State : uint8_t { FREE, QUEUED, RUNNING, DONE } state = State::FREE;
+    bool (*work)(Job&) = 0;
+    typename AM::CodePath path;
+  };
+
+  //work function: runs on a worker thread, must not call ArduMon; return false to send no response
+  typedef bool (*work_t)(Job &job);
+
+  //register this with ArduMon::addCmd() to offload a command to work
+  struct Cmd : public AM::Runnable {
+    ArduMonOffload &o; const work_t work;
+    Cmd(ArduMonOffload &_o, const work_t _work) : o(_o), work(_work) {}
+    bool run(AM &am) { return o.submit(am, work); }
+  };
+
+  ArduMonOffload() {}
+
+  ArduMonOffload(const ArduMonOffload&) = delete;
+  ArduMonOffload& operator=(const ArduMonOffload&) = delete;
+
+  //start the workers; call this from the Arduino setup() method
+  //returns false if the workers could not be started, in which case work will run in the handlers
+  bool begin() {
+#if defined(AM_OFFLOAD_THREADS)
+    for (uint8_t i = 0; i < num_workers; i++) workers[i] = std::thread([this]() { workerLoop(); });
+    started = num_workers > 0;
+    return started;
+#elif defined(AM_OFFLOAD_FREERTOS)
+    pending = xSemaphoreCreateCounting(max_jobs, 0);
+    if (!pending) return false;
+    for (uint8_t i = 0; i < num_workers; i++) {
+      if (xTaskCreate(workerTask, "ArduMonOffload", 4096, this, 1, 0) != pdPASS) break;
+      started = true; //at least one worker
+    }
+    return started;
+#else
+    return false;
+#endif
+  }
+
+#ifdef AM_OFFLOAD_THREADS
+  ~ArduMonOffload() {
+    { std::lock_guard<std::mutex> lock(mutex); stopping = true; }
+    cv.notify_all();
+    for (uint8_t i = 0; i < num_workers; i++) if (workers[i].joinable()) workers[i].join();
+  }
+#endif
+
+  //binary mode: if a job has finished then send its response, at most one per call
+  //call this from the Arduino loop() method; returns true if a response was sent
+  bool tick(AM &am) {
+    if (!am.isBinaryMode() || am.isHandling() || am.isSendingPacket()) return false;
+    lock();
+    Job *job = find(Job::State::DONE);
+    unlock();
+    if (!job) return false;
+    const bool ok = send(am, *job) && am.sendPacket();
+    lock();
+    job->state = Job::State::FREE;
+    unlock();
+    return ok;
+  }
+
+  //the handler of an offloaded command, see Cmd
+  bool submit(AM &am, const work_t work) {
+
+    if (!am.isBinaryMode()) return false; //text mode not supported
+
+    if (!am.skip()) return false;
+    const uint8_t n = am.argc() - 1; //argc counts the last byte of the code
+    if (n > max_job_bytes) return false;
+
+    lock();
+    Job *job = started ? find(Job::State::FREE) : 0;
+    if (job) job->state = Job::State::RUNNING; //claim it while filling it in
+    unlock();
+
+    Job inline_job; //all job slots busy, or no workers
+    Job &j = job ? *job : inline_job;
+
+    j.work = work; j.path = am.getCodePath(); j.in_len = n; j.in_pos = 0; j.out_len = 0;
+    for (uint8_t i = 0; i < n; i++) am.recv(j.in[i]);
+
+    if (!job) return (!work(j) || send(am, j)) && am.endHandler();
+
+    lock();
+    job->state = Job::State::QUEUED;
+    unlock();
+#if defined(AM_OFFLOAD_THREADS)
+    cv.notify_one();
+#elif defined(AM_OFFLOAD_FREERTOS)
+    xSemaphoreGive(pending);
+#endif
+
+    return am.endHandler(); //sends nothing, the response is sent later by tick()
+  }
+
+private:
+
+  Job jobs[max_jobs > 0 ? max_jobs : 1];
+
+  //the first job in the given state, or 0 if none; call with lock held
+  Job *find(const typename Job::State state) {
+    for (uint8_t i = 0; i < max_jobs; i++) if (jobs[i].state == state) return jobs + i;
+    return 0;
+  }
+
+  bool send(AM &am, Job &job) {
+    return am.sendCode(job.path).sendRaw(reinterpret_cast<const char*>(job.out), job.out_len);
+  }
+
+  //run the next queued job, if any; called on a worker thread
+  void runOne() {
+    lock();
+    Job *job = find(Job::State::QUEUED);
+    if (job) job->state = Job::State::RUNNING;
+    unlock();
+    if (!job) return;
+    const bool ok = job->work(*job);
+    lock();
+    job->state = ok ? Job::State::DONE : Job::State::FREE;
+    unlock();
+  }
+
+#if defined(AM_OFFLOAD_THREADS)
+
+  std::thread workers[num_workers > 0 ? num_workers : 1];
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool stopping = false, started = false;
+
+  void lock() { mutex.lock(); }
+  void unlock() { mutex.unlock(); }
+
+  void workerLoop() {
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lk(mutex);
+        cv.wait(lk, [this]() { return stopping || find(Job::State::QUEUED); });
+        if (stopping) return;
+      }
+      runOne();
+    }
+  }
+
+#elif defined(AM_OFFLOAD_FREERTOS)
+
+  SemaphoreHandle_t pending = 0; //counts queued jobs
+  portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+  bool started = false;
+
+  void lock() { portENTER_CRITICAL(&mux); }
+  void unlock() { portEXIT_CRITICAL(&mux); }
+
+  static void workerTask(void *arg) {
+    ArduMonOffload &o = *static_cast<ArduMonOffload*>(arg);
+    for (;;) if (xSemaphoreTake(o.pending, portMAX_DELAY) == pdTRUE) o.runOne();
+  }
+
+#else
+
+  const bool started = false;
+
+  void lock() {}
+  void unlock() {}
+
+#endif
+};
+
+#endif //AM_OFFLOAD_H
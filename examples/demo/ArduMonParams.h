@@ -0,0 +1,195 @@
+#ifndef AM_PARAMS_H
+#define AM_PARAMS_H
+
+/**
+ * ArduMon: Yet another Arduino serial command library.
+ *
+ * See https://github.com/martyvona/ArduMon/blob/main/README.md
+ *
+ * This demonstrates a parameter cache on the client side of a binary link which is kept up to date by the server,
+ * so that repeated reads of the same parameter are served locally instead of each costing a round trip.
+ *
+ * On the server ArduMonParams watches a set of variables registered with add().  Its get command "pg id [watch]"
+ * responds with a packet containing the command code, the parameter id, and the current value bytes, and by default
+ * also subscribes the client to that parameter.  Then whenever ArduMonParams::tick() sees that the value of a
+ * subscribed parameter has changed, whether by a command, by a different interface, or by the firmware itself, it
+ * pushes the new value to the client in the same packet format.  Passing watch=0 unsubscribes.  Changes are found by
+ * comparing each subscribed variable to a shadow copy, so nothing needs to be done at the places where they are set.
+ *
+ * On the client ArduMonParamCache is registered as the command handler for the server's get command code, so that it
+ * receives both the responses to its requests and the pushed updates.  get() then returns the latest value without
+ * any communication, or false if the parameter has not been received yet, in which case request() asks for it.
+ * fetch() combines those, pumping the client's update loop until the value arrives.
+ *
+ * In text mode "pg id" responds with the id and value bytes in hex, and changes are not pushed.
+ *
+ * Copyright 2025 Marsette A. Vona (martyvona@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+template <typename AM, uint8_t max_params, uint8_t max_bytes = 4 * max_params> class ArduMonParams {
+public:
+
+  struct GetCmd : public AM::Runnable {
+    ArduMonParams& ps; GetCmd(ArduMonParams &_ps) : ps(_ps) {}
+    bool run(AM &am) { return ps.get(am); }
+  };
+
+  GetCmd get_cmd;
+
+  ArduMonParams() : get_cmd(*this) {}
+
+  //watch size bytes at ptr as parameter id getNumParams(); returns false if max_params or max_bytes would be exceeded
+  bool add(const void *ptr, const uint8_t size) {
+    if (num_params == max_params || size > max_bytes - num_bytes) return false;
+    Param &p = params[num_params++];
+    p.ptr = static_cast<const uint8_t*>(ptr); p.size = size; p.shadow = shadow + num_bytes; p.watched = false;
+    num_bytes += size;
+    return true;
+  }
+
+  template <typename T> bool add(const T &v) { return add(&v, sizeof(T)); }
+
+  uint8_t getNumParams() { return num_params; }
+
+  //binary mode: limit the rate of the change packets sent by tick(), see AM::TokenBucket; a change that is held back is
+  //sent later with its latest value; this shapes just these packets, unlike AM::setSendRate() which shapes all packets
+  void setRate(const unsigned long bytes_per_sec, const uint16_t burst_bytes = 0) {
+    rate.set(bytes_per_sec, burst_bytes);
+  }
+
+  //handler for "pg id [watch]"
+  bool get(AM &am) {
+
+    //in binary mode the code path of this command is also the code path of the packets it sends
+    uint8_t id; bool watch = true;
+    if (!am.skip().recv(id)) return false;
+    if (am.argc() > 2 && !am.recv(watch)) return false;
+
+    if (am.isBinaryMode()) {
+      if (id < num_params) { Param &p = params[id]; p.watched = watch; p.update(); }
+      notify_path = am.getCodePath();
+      return send(am, id) && am.endHandler();
+    }
+
+    am.send(id);
+    if (id < num_params) {
+      Param &p = params[id]; p.update();
+      for (uint8_t i = 0; i < p.size; i++) am.send(p.shadow[i], AM::FMT_HEX);
+    }
+    return am.endHandler();
+  }
+
+  //binary mode: if a watched parameter has changed since it was last sent then send it, at most one per call
+  //call this from the Arduino loop() method; returns true if a parameter was sent
+  bool tick(AM &am) {
+    if (!am.isBinaryMode() || am.isHandling() || am.isSendingPacket()) return false;
+    for (uint8_t i = 0; i < num_params; i++) {
+      const uint8_t id = next_id; next_id = (next_id + 1) % num_params; //round robin so no param can starve others
+      Param &p = params[id];
+      if (p.watched && p.changed()) {
+        if (!rate.take(p.size + 3 + 2*notify_path.n)) return false; //length, codes (up to 2 bytes each), id, checksum
+        p.update();
+        return send(am, id) && am.sendPacket();
+      }
+    }
+    return false;
+  }
+
+private:
+
+  struct Param {
+    const uint8_t *ptr; uint8_t *shadow; uint8_t size; bool watched;
+    bool changed() { return memcmp(ptr, shadow, size) != 0; }
+    void update() { memcpy(shadow, ptr, size); }
+  };
+
+  //send code path, id, and value bytes (none if id is unknown), but not the packet
+  bool send(AM &am, const uint8_t id) {
+    if (!am.sendCode(notify_path).send(id)) return false;
+    return id >= num_params || am.sendRaw(reinterpret_cast<const char*>(params[id].shadow), params[id].size);
+  }
+
+  Param params[max_params > 0 ? max_params : 1];
+  uint8_t shadow[max_bytes > 0 ? max_bytes : 1];
+  uint8_t num_params = 0, num_bytes = 0, next_id = 0;
+  typename AM::CodePath notify_path;
+  typename AM::TokenBucket rate;
+};
+
+template <typename AM, uint8_t max_params, uint8_t max_param_bytes = 8> class ArduMonParamCache
+  : public AM::Runnable {
+public:
+
+  //register this cache on the client as the handler for packets with the server's get command code
+  bool bind(AM &am, const typename AM::cmd_code_t code) {
+    if (!am.removeCmd(code).addCmd(this, code)) return false;
+    get_code = code;
+    return true;
+  }
+
+  bool unbind(AM &am) { return am.removeCmd(get_code); }
+
+  //ask the server to send parameter id, and to push later changes iff watch
+  bool request(AM &am, const uint8_t id, const bool watch = true) {
+    return am.sendCode(get_code).send(id).send(watch).sendPacket();
+  }
+
+  //get the cached value of parameter id; returns false if it has not been received or its size is not sizeof(T)
+  template <typename T> bool get(const uint8_t id, T &v) {
+    if (!has(id) || sizes[id] != sizeof(T)) return false;
+    memcpy(&v, values[id], sizeof(T));
+    return true;
+  }
+
+  bool has(const uint8_t id) { return id < max_params && valid[id]; }
+
+  //number of values received for parameter id, including the first, modulo 256
+  uint8_t getUpdates(const uint8_t id) { return id < max_params ? updates[id] : 0; }
+
+  void invalidate(const uint8_t id) { if (id < max_params) valid[id] = false; }
+
+  //get() the cached value if any, otherwise request() it and call pump() until it arrives or timeout_ms elapses
+  //pump() must call am.update() and do whatever else is needed to move bytes to and from the server
+  template <typename T, typename F>
+  bool fetch(AM &am, const uint8_t id, T &v, F pump, const typename AM::millis_t timeout_ms) {
+    if (get(id, v)) return true;
+    if (!request(am, id)) return false;
+    const typename AM::millis_t start = millis();
+    while (!has(id) && millis() - start < timeout_ms) pump(); //difference is correct also after millis() wraps
+    return get(id, v);
+  }
+
+  //handle a get response or pushed update: code id [value bytes]
+  //a packet with no value bytes, e.g. if the server does not know the id, invalidates the cached value
+  bool run(AM &am) {
+    uint8_t id; if (!am.skip().recv(id)) return false;
+    const uint8_t n = am.argc() - 2; //argc counts the last byte of the code, the id, and the value bytes
+    if (id >= max_params || n > max_param_bytes) return am.skip(n).endHandler();
+    for (uint8_t i = 0; i < n; i++) if (!am.recv(values[id][i])) return false;
+    sizes[id] = n;
+    valid[id] = n > 0;
+    if (n > 0) ++updates[id];
+    return am.endHandler();
+  }
+
+private:
+
+  uint8_t values[max_params > 0 ? max_params : 1][max_param_bytes];
+  uint8_t sizes[max_params > 0 ? max_params : 1] = {}, updates[max_params > 0 ? max_params : 1] = {};
+  bool valid[max_params > 0 ? max_params : 1] = {};
+  typename AM::cmd_code_t get_code = 0;
+};
+
+#endif //AM_PARAMS_H
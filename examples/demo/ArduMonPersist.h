@@ -0,0 +1,190 @@
+#ifndef AM_PERSIST_H
+#define AM_PERSIST_H
+
+/**
+ * ArduMon: Yet another Arduino serial command library.
+ *
+ * See https://github.com/martyvona/ArduMon/blob/main/README.md
+ *
+ * This demonstrates write-behind persistence of parameters to EEPROM, flash, or a file, so that set commands stay fast
+ * no matter how often a host changes the values.
+ *
+ * Writing nonvolatile memory from a set handler stalls loop() for milliseconds per byte, e.g. about 3.3ms per byte of
+ * AVR EEPROM, and a host that streams setpoints would soon wear it out.  Instead ArduMonPersist watches a set of
+ * variables registered with add(), like ArduMonParams, so nothing needs to be done where they are set.  When tick()
+ * finds that a value changed, it waits delay_ms for more changes, which are coalesced, and then commits a snapshot of
+ * all of the values as one record.  The record is written one byte at a time from tick(), and only while the storage
+ * is ready() and the time budget of that tick() call lasts, so loop() is never blocked waiting for the storage.
+ *
+ * The storage is divided into a ring of record slots, and each commit goes to the slot after the previous one, which
+ * spreads the wear over the whole storage.  Each record is the values, a checksum, and a sequence number, which is
+ * written last.  So a record that was only partly written when power was lost is either rejected by its checksum or
+ * still has the oldest sequence number in the ring, and begin() restores the values from the newest complete record.
+ * At most 127 slots are used so that the 8 bit sequence numbers of the ring can be ordered.
+ *
+ * The storage is accessed through the ArduMonStorage interface; ArduMonEEPROM adapts the AVR EEPROM, and the native
+ * demo server uses a file instead, see native/FileStorage.h.
+ *
+ * Copyright 2025 Marsette A. Vona (martyvona@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+//byte addressed nonvolatile storage
+class ArduMonStorage {
+public:
+
+  virtual ~ArduMonStorage() {}
+
+  virtual uint16_t size() = 0; //number of bytes
+
+  virtual uint8_t read(const uint16_t addr) = 0;
+
+  //write may only start writing v and return before it is done, then ready() is false until it is
+  virtual void write(const uint16_t addr, const uint8_t v) = 0;
+
+  virtual bool ready() { return true; }
+};
+
+#if defined(ARDUINO) && defined(__AVR__)
+#include <avr/eeprom.h>
+
+//the AVR EEPROM as ArduMonStorage; write() only starts writing a byte that differs and does not wait for it
+//the storage is the _sz bytes of the EEPROM starting at _base, so that the rest can be used by other code
+//_sz 0 means all bytes from _base to the end of the EEPROM, and a larger _sz is clamped to that
+class ArduMonEEPROM : public ArduMonStorage {
+public:
+  ArduMonEEPROM(const uint16_t _base = 0, const uint16_t _sz = 0) :
+    base(_base <= E2END ? _base : E2END + 1), sz(_sz == 0 || _sz > E2END + 1 - base ? E2END + 1 - base : _sz) {}
+  uint16_t size() { return sz; }
+  uint8_t read(const uint16_t addr) { return eeprom_read_byte(reinterpret_cast<const uint8_t*>(base + addr)); }
+  void write(const uint16_t addr, const uint8_t v) {
+    if (read(addr) != v) eeprom_write_byte(reinterpret_cast<uint8_t*>(base + addr), v);
+  }
+  bool ready() { return eeprom_is_ready(); }
+private:
+  const uint16_t base, sz;
+};
+#endif
+
+template <uint8_t max_params, uint8_t max_bytes = 4 * max_params> class ArduMonPersist {
+public:
+
+  //persist size bytes at ptr; returns false if max_params or max_bytes would be exceeded, or if begin() was called
+  bool add(void *ptr, const uint8_t size) {
+    if (storage || num_params == max_params || size > max_bytes - num_bytes) return false;
+    Param &p = params[num_params++];
+    p.ptr = static_cast<uint8_t*>(ptr); p.size = size; p.shadow = shadow + num_bytes;
+    num_bytes += size;
+    return true;
+  }
+
+  template <typename T> bool add(T &v) { return add(&v, sizeof(T)); }
+
+  //start persisting to s after all params were add()ed, restoring them from the newest complete record, if any
+  //returns true iff the params were restored; otherwise they keep their current values, which are committed on the
+  //first tick()
+  bool begin(ArduMonStorage &s, const unsigned long _delay_ms = 1000) {
+    storage = &s; delay_ms = _delay_ms;
+    const uint16_t n = s.size() / recSize();
+    num_slots = n < 127 ? n : 127;
+    bool found = false;
+    for (uint8_t i = 0; i < num_slots; i++) {
+      if (!valid(i)) continue;
+      const uint8_t q = s.read(slotAddr(i) + recSize() - 1);
+      if (!found || static_cast<int8_t>(q - seq) > 0) { found = true; seq = q; slot = i; }
+    }
+    if (found) {
+      for (uint8_t i = 0; i < num_bytes; i++) shadow[i] = s.read(slotAddr(slot) + i);
+      for (uint8_t i = 0; i < num_params; i++) memcpy(params[i].ptr, params[i].shadow, params[i].size);
+    } else { //so that the first commit goes to slot 0 and the values are committed
+      slot = num_slots - 1;
+      dirty_ms = millis() - delay_ms; dirty = true;
+    }
+    return found;
+  }
+
+  //commit changed values in the background, writing for at most budget_us
+  //call this from the Arduino loop() method; returns true if a record was completely written
+  bool tick(const unsigned long budget_us = 200) {
+    if (!storage || num_slots == 0) return false;
+    if (!dirty && changed()) { dirty = true; dirty_ms = millis(); }
+    if (!writing && dirty && millis() - dirty_ms >= delay_ms) { //start a commit
+      dirty = false;
+      for (uint8_t i = 0; i < num_params; i++) memcpy(params[i].shadow, params[i].ptr, params[i].size);
+      slot = (slot + 1) % num_slots; ++seq;
+      uint8_t sum = num_bytes + seq; //seeded with the layout, so a record of a different one is likely rejected
+      for (uint8_t i = 0; i < num_bytes; i++) sum += shadow[i];
+      chk = static_cast<uint8_t>(-sum);
+      writing = true;
+    }
+    if (!writing) return false;
+    const unsigned long start_us = micros();
+    while (storage->ready()) { //values, then checksum, then sequence number
+      storage->write(slotAddr(slot) + pos, pos < num_bytes ? shadow[pos] : pos == num_bytes ? chk : seq);
+      if (++pos == recSize()) { pos = 0; writing = false; ++num_commits; return true; }
+      if (micros() - start_us >= budget_us) break;
+    }
+    return false;
+  }
+
+  //commit any changed values now, blocking until they are written, e.g. before a planned power down or reset
+  void flush() {
+    if (!storage || num_slots == 0) return;
+    if (dirty || changed()) { dirty = true; dirty_ms = millis() - delay_ms; }
+    while (writing || dirty) tick(-1);
+  }
+
+  //true if a value changed since it was last committed, or a commit is in progress
+  bool isPending() { return writing || dirty || changed(); }
+
+  uint32_t getNumCommits() { return num_commits; }
+
+  uint8_t getNumSlots() { return num_slots; }
+
+private:
+
+  struct Param {
+    uint8_t *ptr; uint8_t *shadow; uint8_t size;
+  };
+
+  //params differ from the last commit; a change during a commit is committed again after that one
+  bool changed() {
+    for (uint8_t i = 0; i < num_params; i++) if (memcmp(params[i].ptr, params[i].shadow, params[i].size)) return true;
+    return false;
+  }
+
+  uint16_t recSize() { return num_bytes + 2; } //values, checksum, sequence number; up to 257 bytes
+
+  uint16_t slotAddr(const uint8_t i) { return static_cast<uint16_t>(i) * recSize(); }
+
+  bool valid(const uint8_t i) {
+    uint8_t sum = num_bytes;
+    for (uint16_t j = 0; j < recSize(); j++) sum += storage->read(slotAddr(i) + j);
+    return sum == 0;
+  }
+
+  Param params[max_params > 0 ? max_params : 1];
+  uint8_t shadow[max_bytes > 0 ? max_bytes : 1]; //values of the last commit
+  uint8_t num_params = 0, num_bytes = 0;
+
+  ArduMonStorage *storage = 0;
+  unsigned long delay_ms = 0, dirty_ms = 0; //when a change was first seen since the last commit started
+  bool dirty = false, writing = false;
+  uint8_t num_slots = 0, slot = 0, seq = 0, chk = 0;
+  uint16_t pos = 0; //next byte of the record being written
+  uint32_t num_commits = 0;
+};
+
+#endif //AM_PERSIST_H
@@ -0,0 +1,91 @@
+#ifndef AM_PREPARED_H
+#define AM_PREPARED_H
+
+/**
+ * ArduMon: Yet another Arduino serial command library.
+ *
+ * See https://github.com/martyvona/ArduMon/blob/main/README.md
+ *
+ * This demonstrates preparing a binary command packet once and then re-sending it many times with different values in
+ * some of its fields, e.g. to stream setpoint updates at a high rate from a host.
+ *
+ * The packet is encoded once into an ArduMonPrepared with sendCode() and add(), which returns the offset of each field
+ * in the packet, and then end() fills in its length and checksum.  Later set() overwrites a field in place and adjusts
+ * the checksum by the difference of the byte sums of the new and old field values, so re-encoding costs only the size
+ * of the changed field rather than the whole packet.  send() hands the finished packet to ArduMon::sendFramed(), which
+ * copies it to the send buffer without computing the checksum again.
+ *
+ * Copyright 2025 Marsette A. Vona (martyvona@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+template <typename AM, uint8_t max_packet_bytes = 32> class ArduMonPrepared {
+public:
+
+  //start encoding a new packet
+  ArduMonPrepared& begin() { buf[0] = 0; len = 1; ok = true; return *this; } //first byte is reserved for length
+
+  //append a command code in the same format as ArduMon::sendCode()
+  ArduMonPrepared& sendCode(const typename AM::cmd_code_t code) {
+    if (code < 0x80 || AM::MAX_CMD_CODE <= 0xff) return append(static_cast<uint8_t>(code));
+    return append(static_cast<uint8_t>((code >> 8) | 0x80)).append(static_cast<uint8_t>(code));
+  }
+
+  //append a little endian value and return its offset in the packet, for use with set()
+  template <typename T> uint8_t add(const T &v) { const uint8_t at = len; append(v); return at; }
+
+  //finish encoding: set the packet length and checksum; returns false if the packet did not fit
+  bool end() {
+    if (!ok) return false;
+    buf[0] = static_cast<char>(len + 1);
+    uint8_t sum = 0;
+    for (uint8_t i = 0; i < len; i++) sum += static_cast<uint8_t>(buf[i]);
+    buf[len] = static_cast<char>(-sum);
+    return true;
+  }
+
+  //overwrite the field at offset, which was returned by add() with the same type, and update the checksum
+  //no-op if the packet was not successfully end()ed
+  template <typename T> ArduMonPrepared& set(const uint8_t offset, const T &v) {
+    const uint8_t n = static_cast<uint8_t>(buf[0]); //0 if not end()ed
+    if (!ok || offset == 0 || offset + sizeof(T) >= n) return *this;
+    const char * const bytes = reinterpret_cast<const char*>(&v);
+    uint8_t delta = 0;
+    for (uint8_t i = 0; i < sizeof(T); i++) {
+      delta += static_cast<uint8_t>(bytes[i]) - static_cast<uint8_t>(buf[offset + i]);
+      buf[offset + i] = bytes[i];
+    }
+    buf[n - 1] = static_cast<char>(static_cast<uint8_t>(buf[n - 1]) - delta);
+    return *this;
+  }
+
+  //send the packet with ArduMon::sendFramed(); returns false if it was not successfully end()ed
+  bool send(AM &am) { return ok && buf[0] != 0 && am.sendFramed(buf); }
+
+  const char *getPacket() { return buf; }
+
+private:
+
+  template <typename T> ArduMonPrepared& append(const T &v) {
+    if (len + sizeof(T) >= max_packet_bytes) { ok = false; return *this; } //reserve the last byte for the checksum
+    memcpy(buf + len, &v, sizeof(T)); len += sizeof(T);
+    return *this;
+  }
+
+  char buf[max_packet_bytes > 2 ? max_packet_bytes : 2] = {};
+  uint8_t len = 1;
+  bool ok = false;
+};
+
+#endif //AM_PREPARED_H
@@ -0,0 +1,214 @@
+#ifndef AM_RECORD_H
+#define AM_RECORD_H
+
+/**
+ * ArduMon: Yet another Arduino serial command library.
+ *
+ * See https://github.com/martyvona/ArduMon/blob/main/README.md
+ *
+ * This demonstrates sending only selected fields of a telemetry record, so that the link carries what each client
+ * actually uses rather than the whole record.
+ *
+ * The record is a struct of type R, and its fields are described once with add(), in order, e.g.
+ * add(telemetry.temperature); each field is then identified by its index, and a set of fields by a 32 bit mask.
+ * send() sends the mask, with the bits of any unknown fields cleared, followed by the value of each selected field in
+ * index order, so that a client that knows the same description can decode the response.
+ *
+ * The get command "tm mask [period_ms]" responds in this format.  In binary mode the response packet starts with the
+ * code path of the get command, see ArduMon::getCodePath(), and the request also sets the subscription of the client:
+ * if period_ms is given and not 0, then tick() also sends the fields selected by mask every period_ms; otherwise there
+ * is no subscription.
+ *
+ * In text mode the mask is sent in hex and the fields in their usual text formats.
+ *
+ * tick(am) skips a period while the send buffer is busy.  tick(am, slots) instead puts each sample into a conflating
+ * send slot, see ArduMonSlots.h, so the record is sampled every period regardless and only the newest sample is sent.
+ *
+ * Copyright 2025 Marsette A. Vona (martyvona@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+template <typename AM, typename R, uint8_t max_fields = 32> class ArduMonRecord {
+public:
+
+  static_assert(max_fields <= 32, "at most 32 fields can be selected by a 32 bit mask");
+
+  //the same types as the demo em command
+  enum class Type : uint8_t { CHR, BLL, U08, I08, U16, I16, U32, I32, U64, I64, F32, F64 };
+
+  struct GetCmd : public AM::Runnable {
+    ArduMonRecord& rec; GetCmd(ArduMonRecord &_rec) : rec(_rec) {}
+    bool run(AM &am) { return rec.get(am); }
+  };
+
+  GetCmd get_cmd;
+
+  //refresh, if not 0, is called to update the record before its fields are sent
+  ArduMonRecord(const R &_record, void (*_refresh)() = 0)
+    : get_cmd(*this), record(reinterpret_cast<const uint8_t*>(&_record)), refresh(_refresh) {}
+
+  //describe the next field, which must be a member of the record, e.g. add(telemetry.temperature)
+  //returns false if there are already max_fields
+  template <typename T> bool add(const T &field) {
+    const uint8_t *p = reinterpret_cast<const uint8_t*>(&field);
+    if (p < record || p + sizeof(T) > record + sizeof(R)) return false;
+    return add(p - record, typeOf(field));
+  }
+
+  //describe the next field by its byte offset in the record and its type
+  bool add(const uint16_t offset, const Type type) {
+    if (num_fields == max_fields || offset + size(type) > sizeof(R)) return false;
+    fields[num_fields].offset = offset; fields[num_fields].type = type;
+    ++num_fields;
+    return true;
+  }
+
+  uint8_t getNumFields() { return num_fields; }
+
+  //the mask that selects all fields
+  uint32_t all() { return num_fields == 32 ? ~0UL : (1UL << num_fields) - 1; }
+
+  //send the mask, with the bits of any unknown fields cleared, and then the fields selected by it in index order
+  //binary mode: the mask is sent as a little endian uint32_t, and each field in its binary format
+  //this does not start or end the packet, so the caller can send the code first and call sendPacket() after
+  bool send(AM &am, uint32_t mask) {
+    mask &= all();
+    if (refresh && mask) refresh();
+    if (!am.send(mask, am.isBinaryMode() ? 0 : AM::FMT_HEX)) return false;
+    for (uint8_t i = 0; i < num_fields; i++) if ((mask&(1UL << i)) && !sendField(am, fields[i])) return false;
+    return true;
+  }
+
+  //handler for "tm mask [period_ms]"
+  bool get(AM &am) {
+
+    //in binary mode the code path of this command is also the code path of the packets it sends
+    uint32_t mask; uint16_t period = 0;
+    if (!am.skip().recv(mask)) return false;
+    if (am.isBinaryMode() ? am.argc() > 5 : am.argc() > 2) { if (!am.recv(period)) return false; }
+
+    if (am.isBinaryMode()) {
+      sub_path = am.getCodePath(); sub_mask = mask; sub_period_ms = period; last_sent = millis();
+      if (!am.sendCode(sub_path)) return false;
+    }
+    return send(am, mask) && am.endHandler();
+  }
+
+  //binary mode: if there is a subscription and its period has elapsed then send the subscribed fields
+  //call this from the Arduino loop() method; returns true if a packet was sent
+  bool tick(AM &am) {
+    if (!sub_period_ms || !am.isBinaryMode() || am.isHandling() || am.isSendingPacket()) return false;
+    const unsigned long now = millis();
+    if (now - last_sent < sub_period_ms) return false;
+    last_sent = now;
+    return am.sendCode(sub_path) && send(am, sub_mask) && am.sendPacket();
+  }
+
+  //binary mode: like tick(am), but put the packet into the slot of slots keyed by the code of the get command, instead
+  //of sending it, replacing any older packet there that was not yet sent; returns true if a packet was put
+  //call this and then slots.tick(am) from the Arduino loop() method
+  template <typename S> bool tick(AM &am, S &slots) {
+    if (!am.isBinaryMode()) return false;
+    if (!sub_period_ms) { slots.drop(subKey()); return false; } //don't send a sample taken before unsubscribing
+    const unsigned long now = millis();
+    if (now - last_sent < sub_period_ms) return false;
+    last_sent = now;
+    char packet[S::SLOT_SZ];
+    return encode(packet, sizeof(packet), sub_path, sub_mask) && slots.put(subKey(), packet);
+  }
+
+  //binary mode: encode the packet sent by tick(am), i.e. code path, mask, and fields, with its length and checksum
+  //bytes; returns the packet length, or 0 if it does not fit in buf_sz bytes
+  uint8_t encode(char *buf, const uint8_t buf_sz, const typename AM::CodePath &path, uint32_t mask) {
+    mask &= all();
+    if (refresh && mask) refresh();
+    uint16_t n = 1; //the first byte is the length
+    const auto put = [&](const void *v, const uint8_t sz) { if (n + sz < buf_sz) memcpy(buf + n, v, sz); n += sz; };
+    for (uint8_t i = 0; i < path.n; i++) { //see AM::sendCode()
+      const typename AM::cmd_code_t code = path.code[i];
+      if (AM::MAX_CMD_CODE <= 0xff || code < 0x80) { const uint8_t c = code; put(&c, 1); }
+      else { const uint8_t c[2] = { static_cast<uint8_t>(0x80 | (code >> 8)), static_cast<uint8_t>(code) }; put(c, 2); }
+    }
+    put(&mask, 4);
+    for (uint8_t i = 0; i < num_fields; i++) if (mask&(1UL << i)) put(record + fields[i].offset, size(fields[i].type));
+    if (n >= buf_sz) return 0; //reserve the checksum byte
+    buf[0] = static_cast<char>(n + 1);
+    uint8_t sum = 0;
+    for (uint8_t i = 0; i < n; i++) sum += static_cast<uint8_t>(buf[i]);
+    buf[n] = static_cast<char>(-sum);
+    return n + 1;
+  }
+
+private:
+
+  struct Field { uint16_t offset; Type type; };
+
+  //the slot key of the subscription packets, i.e. the code of the get command, without any group codes
+  uint16_t subKey() const { return sub_path.n ? sub_path.code[sub_path.n - 1] : 0; }
+
+  static uint8_t size(const Type t) {
+    switch (t) {
+      case Type::U16: case Type::I16: return 2;
+      case Type::U32: case Type::I32: case Type::F32: return 4;
+      case Type::U64: case Type::I64: return 8;
+      case Type::F64: return sizeof(double); //4 on AVR
+      default: return 1;
+    }
+  }
+
+  static Type typeOf(const char&)     { return Type::CHR; }
+  static Type typeOf(const bool&)     { return Type::BLL; }
+  static Type typeOf(const uint8_t&)  { return Type::U08; }
+  static Type typeOf(const int8_t&)   { return Type::I08; }
+  static Type typeOf(const uint16_t&) { return Type::U16; }
+  static Type typeOf(const int16_t&)  { return Type::I16; }
+  static Type typeOf(const uint32_t&) { return Type::U32; }
+  static Type typeOf(const int32_t&)  { return Type::I32; }
+  static Type typeOf(const uint64_t&) { return Type::U64; }
+  static Type typeOf(const int64_t&)  { return Type::I64; }
+  static Type typeOf(const float&)    { return Type::F32; }
+  static Type typeOf(const double&)   { return Type::F64; }
+
+  template <typename T> T get(const Field &f) { T v; memcpy(&v, record + f.offset, sizeof(T)); return v; }
+
+  bool sendField(AM &am, const Field &f) {
+    switch (f.type) {
+      case Type::CHR: return am.sendChar(get<char>(f));
+      case Type::BLL: return am.send(get<bool>(f));
+      case Type::U08: return am.send(get<uint8_t>(f));
+      case Type::I08: return am.send(get<int8_t>(f));
+      case Type::U16: return am.send(get<uint16_t>(f));
+      case Type::I16: return am.send(get<int16_t>(f));
+      case Type::U32: return am.send(get<uint32_t>(f));
+      case Type::I32: return am.send(get<int32_t>(f));
+      case Type::U64: return am.send(get<uint64_t>(f));
+      case Type::I64: return am.send(get<int64_t>(f));
+      case Type::F32: return am.send(get<float>(f));
+      case Type::F64: return am.send(get<double>(f));
+      default: return false;
+    }
+  }
+
+  const uint8_t * const record;
+  void (* const refresh)();
+  Field fields[max_fields > 0 ? max_fields : 1];
+  uint8_t num_fields = 0;
+
+  typename AM::CodePath sub_path;
+  uint32_t sub_mask = 0;
+  uint16_t sub_period_ms = 0;
+  unsigned long last_sent = 0;
+};
+
+#endif //AM_RECORD_H
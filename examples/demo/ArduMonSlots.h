@@ -0,0 +1,91 @@
+#ifndef AM_SLOTS_H
+#define AM_SLOTS_H
+
+/**
+ * ArduMon: Yet another Arduino serial command library.
+ *
+ * See https://github.com/martyvona/ArduMon/blob/main/README.md
+ *
+ * This demonstrates conflating send slots for binary mode, e.g. for telemetry where only the newest value matters.
+ *
+ * ArduMon has one send buffer, so a producer that sends faster than the link drains must either wait for the previous
+ * packet to be sent or skip sending.  Instead the producer can put() each complete packet, including its length and
+ * checksum bytes, e.g. as encoded by demo_cmds::Frame, into the slot for a key, e.g. the command code of the packet or
+ * a stream id.  put() never blocks: a new packet for a slot replaces an older one that was not yet sent.  tick()
+ * sends the pending packets with ArduMon::sendFramed() whenever the send buffer is free, taking the slots in round
+ * robin order, so one busy producer cannot starve the others and the link always carries the newest data.
+ *
+ * Copyright 2025 Marsette A. Vona (martyvona@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+template <typename AM, uint8_t num_slots, uint8_t slot_sz = 64> class ArduMonSlots {
+public:
+
+  static const uint8_t SLOT_SZ = slot_sz; //the longest packet that fits in a slot
+
+  //copy the complete packet into the slot for key, replacing any older packet in that slot that was not yet sent
+  //a slot is claimed for key the first time it is used
+  //returns false if the packet is longer than slot_sz or all slots are claimed by other keys
+  bool put(const uint16_t key, const char *packet) {
+    const uint8_t len = static_cast<uint8_t>(packet[0]);
+    if (len < 2 || len > slot_sz) return false;
+    Slot * const s = find(key, true);
+    if (!s) return false;
+    if (s->pending) ++num_conflated;
+    memcpy(s->packet, packet, len);
+    s->pending = true;
+    return true;
+  }
+
+  //discard the packet in the slot for key, if any, e.g. when its producer is stopped
+  void drop(const uint16_t key) { Slot * const s = find(key, false); if (s) s->pending = false; }
+
+  bool isPending(const uint16_t key) { const Slot * const s = find(key, false); return s && s->pending; }
+
+  //number of packets that were replaced before they were sent
+  uint32_t getNumConflated() { return num_conflated; }
+
+  //binary mode: if the send buffer is free then send the next pending packet in round robin order of the slots
+  //call this from the Arduino loop() method; returns true if a packet was sent
+  bool tick(AM &am) {
+    if (!am.isBinaryMode() || am.isHandling() || am.isSendingPacket()) return false;
+    for (uint8_t i = 0; i < num_used; i++) {
+      const uint8_t j = (next + i) % num_used;
+      if (!slots[j].pending) continue;
+      slots[j].pending = false;
+      next = (j + 1) % num_used;
+      return am.sendFramed(slots[j].packet);
+    }
+    return false;
+  }
+
+private:
+
+  struct Slot { uint16_t key; bool pending; char packet[slot_sz]; };
+
+  Slot *find(const uint16_t key, const bool claim) {
+    for (uint8_t i = 0; i < num_used; i++) if (slots[i].key == key) return slots + i;
+    if (!claim || num_used == num_slots) return 0;
+    Slot &s = slots[num_used++];
+    s.key = key; s.pending = false;
+    return &s;
+  }
+
+  Slot slots[num_slots > 0 ? num_slots : 1];
+  uint8_t num_used = 0, next = 0;
+  uint32_t num_conflated = 0;
+};
+
+#endif //AM_SLOTS_H
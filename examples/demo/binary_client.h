@@ -52,8 +52,11 @@ public:
   BinaryClientStage* update(AM& am) { return !started ? start(am) : done(am) ? next : 0; }
 
   bool run(AM& am) {
+    if (am.recvReady()) return am.endHandler(); //ignore the server's ready announcement, e.g. if it was just reset
     ++num_receives;
-    if (!recv(am)) return false;
+    AM::Error e; AM::cmd_code_t code = 0;
+    if (am.recvErrorResponse(ERR_RESPONSE_CODE, e, code)) { if (!recvErr(am, e, code)) return false; }
+    else if (!recv(am)) return false;
     if (done(am) && !removeHandler(am)) return false;
     return true;
   }
@@ -73,6 +76,13 @@ protected:
   virtual bool send(AM& am) = 0;
   virtual bool recv(AM& am) = 0;
   virtual bool done(AM& am) { return num_receives > 0; }
+
+  //called instead of recv() for an error response from the server: fail fast, i.e. log it and end the stage
+  virtual bool recvErr(AM& am, const AM::Error e, const AM::cmd_code_t code) {
+    print(F("ERROR: server error response for command ")); print(static_cast<int>(code)); print(F(": "));
+    print(AM::errMsg(e)); println();
+    return am.skip(am.argc()).endHandler(); //ignore any echo bytes
+  }
   virtual bool addHandler(AM& am)    { return am.setUniversalRunnable(this); }
   virtual bool removeHandler(AM& am) { return am.setUniversalRunnable(0); }
 };
@@ -100,7 +110,30 @@ private:
   int16_t cmd_code = -1;
 };
 
-//this is the first BinaryClientStage instance: it gets the command code for the argc command
+//yet another approach is to describe the server commands in a file, see native/demo_cmds.txt, and generate a header
+//with their codes and typed encoders and decoders, see native/ardumon_gen.cpp and the generated demo_cmds.h
+//the client then only needs to check once that the server has the same commands, by comparing a hash of the table
+class BinaryClientStage_hash : public BinaryClientStage {
+protected:
+  bool send(AM& am) override {
+    print(F("sending hash (")); print(static_cast<int>(demo_cmds::HASH)); print(F(")")); println();
+    char buf[4];
+    return demo_cmds::encodeHash(buf, sizeof(buf)) && am.sendFramed(buf);
+  }
+  bool recv(AM& am) override {
+    uint32_t hash = 0;
+    demo_cmds::decodeHash(am, hash);
+    if (!am.endHandler()) return false;
+    if (hash != demo_cmds::TABLE_HASH) print(F("ERROR: "));
+    print(F("hash received ")); print(hash); print(F(", expected ")); print(demo_cmds::TABLE_HASH); println();
+    return hash == demo_cmds::TABLE_HASH;
+  }
+};
+
+//this is the first BinaryClientStage instance: it checks the command table hash
+BinaryClientStage_hash bc_hash;
+
+//this BinaryClientStage instance gets the command code for the argc command
 BinaryClientStage_gcc bc_gcc_argc("argc");
 
 //BinaryClientStage to demonstrate the argc (arg count) command
@@ -158,62 +191,461 @@ private:
 //these BinaryClientStage instances demonstrate the sfp (set float param) and gfp (get float param) commands
 BinaryClientStage_sfp_gfp bc_sfp_gfp_pi(3.14), bc_sfp_gfp_minus_e(-2.71);
 
-//BinaryClientStage to get the command code for an echo command and then invoke it with a specified value
+//these BinaryClientStage instances get the codes for the fp command group and for its get subcommand
+BinaryClientStage_gcc bc_gcc_fp("fp"), bc_gcc_fp_get("fp.get");
+
+//BinaryClientStage to demonstrate invoking a subcommand
+//the packet starts with the group code, then the subcommand code
+class BinaryClientStage_fp_get : public BinaryClientStage {
+public: BinaryClientStage_fp_get(const float _expected) : expected(_expected) {}
+protected:
+  bool send(AM& am) override {
+    print(F("sending fp.get (")); print(static_cast<int>(bc_gcc_fp.code())); print(F("."));
+    print(static_cast<int>(bc_gcc_fp_get.code())); print(F(")")); println();
+    return am.sendCode(bc_gcc_fp.code()).sendCode(bc_gcc_fp_get.code()).sendPacket();
+  }
+  bool recv(AM& am) override {
+    float param;
+    if (!am.recv(param).endHandler()) return false;
+    if (param != expected) print(F("ERROR: "));
+    print(F("fp.get received ")); print(param); print(F(", expected ")); print(expected); println();
+    return param == expected;
+  }
+private:
+  const float expected;
+};
+
+//this BinaryClientStage instance reads back the value set by bc_sfp_gfp_minus_e
+BinaryClientStage_fp_get bc_fp_get(-2.71);
+
+//this BinaryClientStage instance gets the code for the cmp (compound) command
+BinaryClientStage_gcc bc_gcc_cmp("cmp");
+
+//BinaryClientStage to demonstrate sending several commands in one compound packet
+//the subcommands are fp.get, sfp 1.5, fp.get, and an unknown command code, each prefixed with its length in bytes
+//the single response packet has one record per subcommand that was run: data length, error code, data
+class BinaryClientStage_cmp : public BinaryClientStage {
+public: BinaryClientStage_cmp(const bool _stop_on_error) : stop_on_error(_stop_on_error) {}
+protected:
+  bool send(AM& am) override {
+    print(F("sending cmp (")); print(static_cast<int>(bc_gcc_cmp.code())); print(F(") with 4 subcommands"));
+    if (stop_on_error) print(F(", stop on error"));
+    println();
+    am.sendCode(bc_gcc_cmp.code()).send(static_cast<uint8_t>(stop_on_error ? AM::COMPOUND_STOP_ON_ERROR : 0));
+    if (stop_on_error) am.send(static_cast<uint8_t>(1)).sendCode(BAD_CODE);
+    am.send(static_cast<uint8_t>(2)).sendCode(bc_gcc_fp.code()).sendCode(bc_gcc_fp_get.code());
+    am.send(static_cast<uint8_t>(5)).sendCode(bc_gcc_sfp.code()).send(1.5f);
+    am.send(static_cast<uint8_t>(2)).sendCode(bc_gcc_fp.code()).sendCode(bc_gcc_fp_get.code());
+    if (!stop_on_error) am.send(static_cast<uint8_t>(1)).sendCode(BAD_CODE);
+    return am.sendPacket();
+  }
+  bool recv(AM& am) override {
+    //expected records without stop on error: (4, NONE, -2.71) (0, NONE) (4, NONE, 1.5) (0, BAD_CMD)
+    //expected records with stop on error: (0, BAD_CMD)
+    const uint8_t expected = stop_on_error ? 1 : 4;
+    uint8_t num_records; if (!am.recv(num_records)) return false;
+    bool ok = num_records == expected;
+    for (uint8_t i = 0; ok && i < num_records; i++) {
+      uint8_t len, err; if (!am.recv(len).recv(err)) return false;
+      const bool last = i == num_records - 1;
+      ok = err == static_cast<uint8_t>(last ? AM::Error::BAD_CMD : AM::Error::NONE);
+      ok = ok && len == (last || i == 1 ? 0 : 4);
+      if (ok && len == 4) { float v; if (!am.recv(v)) return false; ok = v == (i == 0 ? -2.71f : 1.5f); }
+    }
+    if (!am.endHandler()) return false;
+    if (!ok) print(F("ERROR: "));
+    print(F("cmp received ")); print(static_cast<int>(num_records)); print(F(" records, expected "));
+    print(static_cast<int>(expected)); println();
+    return ok;
+  }
+private:
+  static const uint8_t BAD_CODE = 100; //not a registered command code
+  const bool stop_on_error;
+};
+
+//these BinaryClientStage instances demonstrate compound commands, with and without stop on error
+BinaryClientStage_cmp bc_cmp(false), bc_cmp_stop(true);
+
+//BinaryClientStage to demonstrate the error response that the server sends when a command fails
+//the command is unknown, and is followed by a request id which the server echoes back in the error response
+class BinaryClientStage_bad_cmd : public BinaryClientStage {
+protected:
+  bool send(AM& am) override {
+    print(F("sending unknown command (")); print(static_cast<int>(BAD_CODE)); print(F(") with request id "));
+    print(static_cast<int>(REQUEST_ID)); println();
+    return am.sendCode(BAD_CODE).send(REQUEST_ID).sendPacket();
+  }
+  bool recv(AM& am) override {
+    print(F("ERROR: expected error response")); println();
+    return am.skip(am.argc()).endHandler();
+  }
+  bool recvErr(AM& am, const AM::Error e, const AM::cmd_code_t code) override {
+    uint8_t id = 0; const bool has_id = am.argc() > 3; //error response code, error, failed command code, request id
+    if (has_id && !am.recv(id)) return false;
+    if (!am.endHandler()) return false;
+    const bool ok = e == AM::Error::BAD_CMD && code == BAD_CODE && has_id && id == REQUEST_ID;
+    if (!ok) print(F("ERROR: "));
+    print(F("error response received: ")); print(AM::errMsg(e)); print(F(" for command "));
+    print(static_cast<int>(code)); print(F(" request id ")); print(static_cast<int>(id)); println();
+    return ok;
+  }
+private:
+  static const uint8_t BAD_CODE = 100, REQUEST_ID = 42;
+};
+
+//this BinaryClientStage instance demonstrates error responses
+BinaryClientStage_bad_cmd bc_bad_cmd;
+
+//BinaryClientStage to check that the server abandons a partial packet once its receive gap expires: it sends only the
+//length and code bytes of a gfp packet and idles for several gaps, during which exactly one RECV_TIMEOUT error response
+//must arrive, and then it sends a whole gfp packet, which must be handled
+class BinaryClientStage_partial : public BinaryClientStage {
+protected:
+  bool send(AM& am) override {
+    print(F("sending partial gfp (")); print(static_cast<int>(bc_gcc_gfp.code())); print(F(") packet, then idling ("));
+    print(IDLE_MS); print(F("ms)")); println();
+    am.getStream()->write(static_cast<uint8_t>(3)); am.getStream()->write(static_cast<uint8_t>(bc_gcc_gfp.code()));
+    start_ms = millis();
+    return true;
+  }
+  bool done(AM& am) override {
+    if (!sent_gfp && millis() - start_ms >= IDLE_MS) {
+      print(F("sending gfp (")); print(static_cast<int>(bc_gcc_gfp.code())); print(F(")")); println();
+      if (!am.send(bc_gcc_gfp.code()).sendPacket()) { print(AM::errMsg(am.clearErr())); println(); }
+      sent_gfp = true;
+    }
+    return got_gfp;
+  }
+  bool recv(AM& am) override {
+    float v = 0;
+    if (!sent_gfp || !am.recv(v).endHandler()) {
+      print(F("ERROR: unexpected response")); println();
+      return false;
+    }
+    got_gfp = true;
+    if (num_errs != 1) print(F("ERROR: "));
+    print(F("gfp received ")); print(v); print(F(" after ")); print(num_errs); print(F(" error responses, expected 1"));
+    println();
+    return num_errs == 1;
+  }
+  bool recvErr(AM& am, const AM::Error e, const AM::cmd_code_t code) override {
+    if (!am.endHandler()) return false;
+    if (e != AM::Error::RECV_TIMEOUT) print(F("ERROR: "));
+    else if (++num_errs > 1) return true; //a server that raises the timeout again on every update() floods the link
+    print(F("error response received: ")); print(AM::errMsg(e)); println();
+    return e == AM::Error::RECV_TIMEOUT;
+  }
+private:
+  static const uint16_t IDLE_MS = 10 * RECV_GAP_US / 1000;
+  unsigned long start_ms = 0;
+  bool sent_gfp = false, got_gfp = false;
+  uint16_t num_errs = 0;
+};
+
+//this BinaryClientStage instance checks recovery from a dropped byte; it's a regression test for ArduMon::failRecv()
+BinaryClientStage_partial bc_partial;
+
+//this BinaryClientStage instance gets the code for the pg (param get) command
+BinaryClientStage_gcc bc_gcc_pg("pg");
+
+//client side cache of the server params, see ArduMonParams.h
+ArduMonParamCache<AM, 1> param_cache;
+
+//BinaryClientStage to demonstrate a client side parameter cache that the server keeps up to date
+//the first read of param 0 (the server's float param) takes a round trip, after that the server pushes any changes
+//instead of setUniversalRunnable() the cache is registered as the client's handler for the pg command code
+class BinaryClientStage_pg : public BinaryClientStage {
+protected:
+  bool send(AM& am) override {
+    print(F("sending pg (")); print(static_cast<int>(bc_gcc_pg.code())); print(F(") for param 0")); println();
+    return param_cache.request(am, 0);
+  }
+  bool recv(AM& am) override { return true; } //not called, the packets go to param_cache
+  bool done(AM& am) override {
+    float v;
+    if (step == 0 && param_cache.get(0, v)) {
+      if (v != 1.5) print(F("ERROR: "));
+      print(F("pg received ")); print(v); print(F(", expected 1.5")); println();
+      print(F("sending sfp (")); print(static_cast<int>(bc_gcc_sfp.code())); print(F(") value=2.25")); println();
+      am.send(bc_gcc_sfp.code()).send(2.25f).sendPacket(); //the server will push the new value
+      step = 1;
+    } else if (step == 1 && param_cache.getUpdates(0) == 2 && param_cache.get(0, v)) {
+      if (v != 2.25) print(F("ERROR: "));
+      print(F("pg cache updated to ")); print(v); print(F(", expected 2.25")); println();
+      print(F("sending pg (")); print(static_cast<int>(bc_gcc_pg.code())); print(F(") to unwatch param 0")); println();
+      param_cache.request(am, 0, false); //the server responds with the value one last time
+      step = 2;
+    } else if (step == 2 && param_cache.getUpdates(0) == 3) return removeHandler(am) || true;
+    return false;
+  }
+  bool addHandler(AM& am) override { return param_cache.bind(am, bc_gcc_pg.code()); }
+  bool removeHandler(AM& am) override { return param_cache.unbind(am); }
+private:
+  uint8_t step = 0;
+};
+
+BinaryClientStage_pg bc_pg; //this BinaryClientStage instance demonstrates the param cache
+
+//this BinaryClientStage instance gets the code for the ssq (sum of squares) command
+BinaryClientStage_gcc bc_gcc_ssq("ssq");
+
+//BinaryClientStage to demonstrate a command that the server offloads to a worker thread
+//gfp is sent right after ssq; on servers with worker threads its response may arrive first
+class BinaryClientStage_ssq : public BinaryClientStage {
+public: BinaryClientStage_ssq(const uint32_t _n) : n(_n) {}
+protected:
+  bool send(AM& am) override {
+    print(F("sending ssq (")); print(static_cast<int>(bc_gcc_ssq.code())); print(F(") n=")); print(n); println();
+    if (!am.send(bc_gcc_ssq.code()).send(n).sendPacket()) return false;
+    print(F("sending gfp (")); print(static_cast<int>(bc_gcc_gfp.code())); print(F(")")); println();
+    return am.send(bc_gcc_gfp.code()).sendPacket();
+  }
+  bool recv(AM& am) override {
+    if (am.argc() == 4) { //the gfp response is just a float
+      float param; if (!am.recv(param).endHandler()) return false;
+      print(F("gfp received ")); print(param); print(num_receives == 1 ? F(" before") : F(" after")); print(F(" ssq"));
+      println();
+      return true;
+    }
+    uint8_t code; uint64_t sum;
+    if (!am.recv(code).recv(sum).endHandler()) return false;
+    const uint64_t expected = static_cast<uint64_t>(n - 1) * n * (2 * static_cast<uint64_t>(n) - 1) / 6;
+    if (sum != expected) print(F("ERROR: "));
+    print(F("ssq received ")); print(sum); print(F(", expected ")); print(expected); println();
+    return sum == expected && code == bc_gcc_ssq.code();
+  }
+  bool done(AM& am) override { return num_receives == 2; }
+private:
+  const uint32_t n;
+};
+
+BinaryClientStage_ssq bc_ssq(100000); //this BinaryClientStage instance demonstrates an offloaded command
+
+//BinaryClientStage to demonstrate streaming setpoints with a prepared sfp packet, one per loop()
+//the packet is encoded once, then for each setpoint only the float field and the checksum are patched
+class BinaryClientStage_prepared_sfp : public BinaryClientStage {
+public: BinaryClientStage_prepared_sfp(const uint8_t _n) : n(_n) {}
+protected:
+  bool send(AM& am) override {
+    field = sfp.begin().sendCode(bc_gcc_sfp.code()).add(0.0f);
+    print(F("streaming ")); print(static_cast<int>(n)); print(F(" prepared sfp ("));
+    print(static_cast<int>(bc_gcc_sfp.code()));
+    print(F(") packets, last value=")); print(value(n - 1)); println();
+    return sfp.end();
+  }
+  bool done(AM& am) override {
+    if (num_sent == n) return num_receives > 0;
+    if (!sfp.set(field, value(num_sent++)).send(am)) { print(AM::errMsg(am.clearErr())); println(); }
+    if (num_sent == n) {
+      print(F("sending gfp (")); print(static_cast<int>(bc_gcc_gfp.code())); print(F(")")); println();
+      am.send(bc_gcc_gfp.code()).sendPacket();
+    }
+    return false;
+  }
+  bool recv(AM& am) override {
+    float param; const float expected = value(n - 1);
+    if (!am.recv(param).endHandler()) return false;
+    if (param != expected) print(F("ERROR: "));
+    print(F("gfp received ")); print(param); print(F(", expected ")); print(expected); println();
+    return param == expected;
+  }
+private:
+  const uint8_t n;
+  uint8_t num_sent = 0, field = 0;
+  ArduMonPrepared<AM> sfp;
+  static float value(const uint8_t i) { return 0.5f * i; }
+};
+
+BinaryClientStage_prepared_sfp bc_prepared_sfp(10); //this BinaryClientStage instance streams 10 setpoints
+
+//BinaryClientStage to demonstrate a streaming command: the server dispatches it as soon as its code is received, and
+//then its handler receives the args as they arrive, and verifies the checksum at the end, see ArduMon::setStreaming()
+class BinaryClientStage_sum : public BinaryClientStage {
+protected:
+  bool send(AM& am) override {
+    int32_t args[NUM_ARGS]; for (uint8_t i = 0; i < NUM_ARGS; i++) args[i] = i + 1;
+    print(F("sending sum (")); print(static_cast<int>(demo_cmds::SUM)); print(F(") with ")); print(NUM_ARGS);
+    print(F(" args")); println();
+    char buf[sizeof(args) + 3];
+    return demo_cmds::encodeSum(buf, sizeof(buf), args, sizeof(args)) && am.sendFramed(buf);
+  }
+  bool recv(AM& am) override {
+    uint16_t n = 0; int32_t sum = 0; const int32_t expected = NUM_ARGS * (NUM_ARGS + 1) / 2;
+    demo_cmds::decodeSum(am, n, sum);
+    if (!am.endHandler()) return false;
+    const bool ok = n == NUM_ARGS && sum == expected;
+    if (!ok) print(F("ERROR: "));
+    print(F("sum received ")); print(n); print(F(" ")); print(sum); print(F(", expected ")); print(NUM_ARGS);
+    print(F(" ")); print(expected); println();
+    return ok;
+  }
+private:
+  static const uint8_t NUM_ARGS = 12; //the packet must fit in the 64 byte serial send buffer of the native client
+};
+
+BinaryClientStage_sum bc_sum; //this BinaryClientStage instance demonstrates a streaming command
+
+//BinaryClientStage to subscribe to two fields of the server's telemetry record, receive them a few times, and then
+//unsubscribe; the response to the unsubscribe request selects no fields, so it is the last packet, see ArduMonRecord.h
+class BinaryClientStage_tm : public BinaryClientStage {
+protected:
+  bool send(AM& am) override { return request(am, MASK, PERIOD_MS); }
+  bool recv(AM& am) override {
+    uint8_t code = 0; uint32_t mask = 0; //the response starts with the tm code, see ArduMonRecord.h
+    if (!demo_cmds::decodeTm(am, code, mask)) return false;
+    if (mask == 0) { ended = true; return am.endHandler() && num_receives > NUM_UPDATES; }
+    float float_param = 0; uint16_t num_errors = 0;
+    if (!am.recv(float_param).recv(num_errors).endHandler()) return false;
+    if (mask != MASK) print(F("ERROR: "));
+    print(F("tm received mask ")); print(mask); print(F(", expected ")); print(MASK); print(F(", float_param="));
+    print(float_param); print(F(", num_errors=")); print(num_errors); println();
+    if (num_receives == NUM_UPDATES && !request(am, 0, 0)) return false;
+    return mask == MASK;
+  }
+  bool done(AM& am) override { return ended; }
+  bool recvErr(AM& am, const AM::Error e, const AM::cmd_code_t code) override {
+    ended = true; return BinaryClientStage::recvErr(am, e, code);
+  }
+private:
+  static const uint32_t MASK = (1UL << 1) | (1UL << 2); //float_param and num_errors
+  static const uint16_t PERIOD_MS = 20;
+  static const uint8_t NUM_UPDATES = 3;
+  bool request(AM& am, const uint32_t mask, const uint16_t period_ms) {
+    print(F("sending tm (")); print(static_cast<int>(demo_cmds::TM)); print(F(") mask=")); print(mask);
+    print(F(" period_ms=")); print(period_ms); println();
+    char buf[9];
+    return demo_cmds::encodeTm(buf, sizeof(buf), mask, period_ms) && am.sendFramed(buf);
+  }
+};
+
+BinaryClientStage_tm bc_tm; //this BinaryClientStage instance demonstrates a telemetry subscription
+
+//BinaryClientStage to time the server's codec paths, see getBenchHandler() in ArduMon.h
+class BinaryClientStage_bench : public BinaryClientStage {
+protected:
+  bool send(AM& am) override {
+    print(F("sending bench (")); print(static_cast<int>(demo_cmds::BENCH)); print(F(") n=")); print(N); println();
+    char buf[5];
+    return demo_cmds::encodeBench(buf, sizeof(buf), N) && am.sendFramed(buf);
+  }
+  bool recv(AM& am) override {
+    uint16_t n = 0; uint32_t us[7];
+    demo_cmds::decodeBench(am, n, us[0], us[1], us[2], us[3], us[4], us[5], us[6]);
+    if (!am.endHandler()) return false;
+    if (n != N) print(F("ERROR: "));
+    print(F("bench received n=")); print(n); print(F(", total us:"));
+    for (uint8_t i = 0; i < 7; i++) { print(F(" ")); print(us[i]); }
+    println();
+    return n == N;
+  }
+private:
+  static const uint16_t N = 10;
+};
+
+BinaryClientStage_bench bc_bench; //this BinaryClientStage instance times the server's codec paths
+
+//BinaryClientStage to batch several sfp (set float param) commands into one cmp (compound) packet, see ArduMonBatch.h
+//the server sends no response to the batch, so then a gfp command reads back the value set by its last subcommand
+class BinaryClientStage_batch : public BinaryClientStage {
+protected:
+  bool send(AM& am) override {
+    print(F("batching ")); print(NUM_SETS); print(F(" sfp (")); print(static_cast<int>(demo_cmds::SFP));
+    print(F(") commands into cmp (")); print(static_cast<int>(demo_cmds::CMP)); print(F(")")); println();
+    char buf[8];
+    for (uint8_t i = 0; i < NUM_SETS; i++) {
+      if (!demo_cmds::encodeSfp(buf, sizeof(buf), value(i)) || !batch.put(am, buf)) return false;
+    }
+    return true; //the batch is sent by tick() once its max delay has elapsed
+  }
+  bool done(AM& am) override {
+    if (batch.tick(am)) {
+      print(F("sent ")); print(batch.getTotalRecords()); print(F(" sfp commands in ")); print(batch.getNumBatches());
+      print(F(" cmp packet, sending gfp (")); print(static_cast<int>(demo_cmds::GFP)); print(F(")")); println();
+      char buf[3];
+      if (!demo_cmds::encodeGfp(buf, sizeof(buf)) || !am.sendFramed(buf)) {
+        print(AM::errMsg(am.clearErr())); println();
+      }
+    }
+    return num_receives > 0;
+  }
+  bool recv(AM& am) override {
+    float v = 0;
+    if (!demo_cmds::decodeGfp(am, v) || !am.endHandler()) return false;
+    const float expected = value(NUM_SETS - 1);
+    if (v != expected) print(F("ERROR: "));
+    print(F("gfp received ")); print(v); print(F(", expected ")); print(expected); println();
+    return v == expected;
+  }
+private:
+  static const uint8_t NUM_SETS = 4;
+  static float value(const uint8_t i) { return 1.25f * (i + 1); } //the last one differs from the value set before
+  ArduMonBatch<AM, 32> batch{demo_cmds::CMP};
+};
+
+BinaryClientStage_batch bc_batch; //this BinaryClientStage instance demonstrates coalescing small command packets
+
+//BinaryClientStage to invoke an echo command with a specified value
+//the command is encoded and its response decoded by the functions generated for it in demo_cmds.h
 template <typename T>
 class BinaryClientStage_echo : public BinaryClientStage {
-public: BinaryClientStage_echo(const char *_cmd, const T _val) : cmd(_cmd), val(_val) {}
+public:
+  typedef uint8_t (*encode_t)(char *buf, const uint8_t buf_sz, const T v);
+  typedef bool (*decode_t)(AM &am, T &v);
+  BinaryClientStage_echo(const char *_cmd, const encode_t _encode, const decode_t _decode, const T _val)
+    : cmd(_cmd), encode(_encode), decode(_decode), val(_val) {}
 protected:
   bool send(AM& am) override {
-    print(F("sending gcc (0) for cmd ")); print(cmd); println();
-    return am.send(static_cast<uint8_t>(0)).send(cmd).sendPacket();
+    print(F("sending ")); print(cmd); print(F(" val=")); print(val); println();
+    char buf[MAX_PACKET_BYTES];
+    return encode(buf, sizeof(buf), val) && am.sendFramed(buf);
   }
   bool recv(AM& am) override {
-    if (num_receives == 1) {
-      uint16_t code; if (!am.recv(code).endHandler()) return false;
-      print(F("gcc received ")); print(code); println();
-      if (code < 0) return false;
-      print(F("sending ")); print(cmd); print(F(" (")); print(code); print(F(") val=")); print(val); println();
-      return am.send(static_cast<uint8_t>(code)).send(val).sendPacket();
-    }
-    T v; if (!am.recv(v).endHandler()) return false;
+    T v = T();
+    decode(am, v);
+    if (!am.endHandler()) return false;
     const bool ok = equals(v, val);
     if (!ok) print(F("ERROR: "));
     print(cmd); print(F(" received ")); print(v); print(F(", expected ")); print(val); println();
     return ok;
   }
-  bool done(AM& am) override { return num_receives > 1; }
   virtual bool equals(const T &a, const T &b) { return a == b; }
 private:
+  static const uint8_t MAX_PACKET_BYTES = 16;
   const char *cmd;
+  const encode_t encode;
+  const decode_t decode;
   const T val;
 };
 
 class BinaryClientStage_echo_str : public BinaryClientStage_echo<const char*> {
 public: using BinaryClientStage_echo<const char*>::BinaryClientStage_echo;
-protected: bool equals(const char * const &a, const char * const &b) override { return strcmp(a,b) == 0; }
+protected: bool equals(const char * const &a, const char * const &b) override { return a && strcmp(a,b) == 0; }
 };
 
 //these BinaryClientStage instances demonstrate the various echo commands
 //substituting sendChar() and recvChar() for send() and recv() would complicate the BinaryClientStage_echo template
 //instead we'll use a separate stage below to deal with chars
-BinaryClientStage_echo_str es("es", "foo");
-BinaryClientStage_echo<bool> eb_f("eb", false), eb_t("eb", true);
-BinaryClientStage_echo<uint8_t> eu8("eu8", 255);
-BinaryClientStage_echo<int8_t> es8_l("es8", -128), es8_h("es8", 127);
-BinaryClientStage_echo<uint16_t> eu16("eu16", 65535);
-BinaryClientStage_echo<int16_t> es16_l("es16", -32768), es16_h("es16", 32767);
-BinaryClientStage_echo<uint32_t> eu32("eu32", UINT32_MAX);
-BinaryClientStage_echo<int32_t> es32_l("es32", INT32_MIN), es32_h("es32", INT32_MAX);
+//the name, the encoder and decoder generated for it in demo_cmds.h, and the value to echo
+#define ECHO_ARGS(Name, name, val) name, demo_cmds::encode##Name, demo_cmds::decode##Name<AM>, val
+BinaryClientStage_echo_str es(ECHO_ARGS(Es, "es", "foo"));
+BinaryClientStage_echo<bool> eb_f(ECHO_ARGS(Eb, "eb", false)), eb_t(ECHO_ARGS(Eb, "eb", true));
+BinaryClientStage_echo<uint8_t> eu8(ECHO_ARGS(Eu8, "eu8", 255));
+BinaryClientStage_echo<int8_t> es8_l(ECHO_ARGS(Es8, "es8", -128)), es8_h(ECHO_ARGS(Es8, "es8", 127));
+BinaryClientStage_echo<uint16_t> eu16(ECHO_ARGS(Eu16, "eu16", 65535));
+BinaryClientStage_echo<int16_t> es16_l(ECHO_ARGS(Es16, "es16", -32768)), es16_h(ECHO_ARGS(Es16, "es16", 32767));
+BinaryClientStage_echo<uint32_t> eu32(ECHO_ARGS(Eu32, "eu32", UINT32_MAX));
+BinaryClientStage_echo<int32_t> es32_l(ECHO_ARGS(Es32, "es32", INT32_MIN)), es32_h(ECHO_ARGS(Es32, "es32", INT32_MAX));
 #ifdef WITH_INT64
-BinaryClientStage_echo<uint64_t> eu64("eu64", UINT64_MAX);
-BinaryClientStage_echo<int64_t> es64_l("es64", INT64_MIN), es64_h("es64", INT64_MAX);
+BinaryClientStage_echo<uint64_t> eu64(ECHO_ARGS(Eu64, "eu64", UINT64_MAX));
+BinaryClientStage_echo<int64_t> es64_l(ECHO_ARGS(Es64, "es64", INT64_MIN)), es64_h(ECHO_ARGS(Es64, "es64", INT64_MAX));
 #endif
 #ifdef WITH_FLOAT
-BinaryClientStage_echo<float> ef_l("ef", -FLT_MAX), ef_h("ef", FLT_MAX);
+BinaryClientStage_echo<float> ef_l(ECHO_ARGS(Ef, "ef", -FLT_MAX)), ef_h(ECHO_ARGS(Ef, "ef", FLT_MAX));
 #ifdef WITH_DOUBLE
-BinaryClientStage_echo<double> ed_l("ed", -DBL_MAX), ed_h("ed", DBL_MAX);
+BinaryClientStage_echo<double> ed_l(ECHO_ARGS(Ed, "ed", -DBL_MAX)), ed_h(ECHO_ARGS(Ed, "ed", DBL_MAX));
 #endif
 #endif
+#undef ECHO_ARGS
 
 //BinaryClientStage instance to get the command codes for the ec (echo char) command
 BinaryClientStage_gcc bc_gcc_ec("ec");
@@ -30,6 +30,15 @@
 #include <ArduMon.h>
 
 #include "ArduMonTimer.h"
+#include "ArduMonParams.h"
+#include "ArduMonOffload.h"
+#include "ArduMonPrepared.h"
+#include "ArduMonGroup.h"
+#include "ArduMonRecord.h"
+#include "ArduMonSlots.h"
+#include "ArduMonBatch.h"
+#include "ArduMonPersist.h"
+#include "demo_cmds.h" //generated from native/demo_cmds.txt by native/ardumon_gen, checked by native/build-native.sh
 
 //builds text server demo by default
 //#define BASELINE_MEM //to check memory usage of boilerplate
@@ -55,14 +64,51 @@
 #define WITH_DOUBLE true
 #define WITH_BINARY true
 #define WITH_TEXT true
+#define WITH_CODE16 false
+#define WITH_STATS true
 
 #define BAUD 115200
 
-#define MAX_CMDS 32
+#define MAX_CMDS 40
 
 #define RECV_BUF_SZ 128
 #define SEND_BUF_SZ 128
 
+//binary mode: discard a partial packet if no byte is received for this long, see ArduMon::setRecvGapUS()
+//at 115200 baud one byte takes ~87us, so this allows for some jitter in the sender while still resyncing quickly
+#define RECV_GAP_US 5000
+
+//text mode: the server abandons a command that is not completely received within this long, see
+//ArduMon::setRecvTimeoutMS(); this also bounds how long the streaming "sum" command blocks loop() while it waits for
+//each argument, which is required for it to stream, see ArduMon::setStreaming()
+#define RECV_TIMEOUT_MS 30000
+
+//receive at most this many bytes per update(), so that other work in loop(), or other instances, are not starved
+#define RECV_BYTES_PER_UPDATE 64
+
+//binary mode: the server limits its sent packets to this many bytes per second on average, with bursts of up to
+//SEND_BURST_BYTES, see ArduMon::setSendRate(); this leaves room on a shared link, e.g. a half duplex radio or RS-485
+//at 115200 baud the link can carry ~11520 bytes per second; set to 0 to disable the limit
+#define SEND_BYTES_PER_SEC 8000
+#define SEND_BURST_BYTES 256
+
+//binary mode: the server sends param change packets, see ArduMonParams.h, at most this many bytes per second
+#define PARAM_BYTES_PER_SEC 1000
+
+//the server commits changed params to storage this long after the first change, coalescing any later ones, see
+//ArduMonPersist.h
+#define PERSIST_DELAY_MS 1000
+
+//binary mode: the server sends an error response packet starting with this code when a command fails
+//followed by the error, the code of the failed command, and one more byte from the failed packet, see
+//ArduMon::setErrorResponse(); the client recognizes these with ArduMon::recvErrorResponse()
+#define ERR_RESPONSE_CODE 0xEE
+
+//text mode: the server sends this after each response when enabled by "quiet 1", see ArduMon::setTextEndMarker()
+//it is an OSC escape sequence with an unassigned number, so terminals will ignore it
+//ardumon_client looks for it to know when a response is complete
+#define TEXT_END_MARKER "\x1b]5379;end\x07"
+
 //it's possible to run the binary client or server with the binary communication on the default serial port
 //e.g. run the binary server this way and connect the Arduino by USB to a host, then run binary client on the host
 //in this situation we need to disable the debug prints as they would also use the default serial port
@@ -74,7 +120,8 @@
 #endif
 
 //specialize the ArduMon class template and call that AM
-using AM = ArduMon<MAX_CMDS, RECV_BUF_SZ, SEND_BUF_SZ, WITH_INT64, WITH_FLOAT, WITH_DOUBLE, WITH_BINARY, WITH_TEXT>;
+using AM = ArduMon<MAX_CMDS, RECV_BUF_SZ, SEND_BUF_SZ, WITH_INT64, WITH_FLOAT, WITH_DOUBLE, WITH_BINARY, WITH_TEXT,
+                   WITH_CODE16, WITH_STATS>;
 
 /* set up the ArduMon input stream AM_STREAM **************************************************************************/
 
@@ -118,6 +165,11 @@ bool count_errors(AM &am) { if (num_errors < 65535) ++num_errors; return am.getD
 
 bool demo_done = false; //terminate the demo when this flag is set
 
+//the demo has one ArduMon instance, but a device with several, e.g. one per serial port, would add each of them to
+//this group, which services them fairly, see ArduMonGroup.h
+ArduMonGroup<1> am_group;
+ArduMonGroup<1>::Of<AM> am_member(am);
+
 #ifdef DEMO_CLIENT
 #include "binary_client.h" //most of the demo binary client is here
 #else
@@ -147,11 +199,24 @@ void setup() {
 
 #ifndef BASELINE_MEM
   am.setErrorHandler(count_errors);
+  am_group.add(am_member, RECV_BYTES_PER_UPDATE);
+  am.setRecvGapUS(RECV_GAP_US); //not used in text mode
+#ifndef DEMO_CLIENT
+  am.setErrorResponse(ERR_RESPONSE_CODE, 1); //not used in text mode
+  am.setRecvTimeoutMS(RECV_TIMEOUT_MS); //in binary mode the receive gap also bounds streaming commands
+  am.setSendRate(SEND_BYTES_PER_SEC, SEND_BURST_BYTES); //not used in text mode
+#endif
 #ifdef DEMO_CLIENT
   am.setSendWaitMS(AM::ALWAYS_WAIT);
 #else
-  am.setTextEcho(true).setTextPrompt(F("ArduMon>"));
+  am.setTextEcho(true).setTextPrompt(F("ArduMon>")).setTextAutoQuiet(); //quiet while a script is sending
   addCmds(); //text or binary server
+  params.setRate(PARAM_BYTES_PER_SEC);
+  if (persist_storage && persist.begin(*persist_storage, PERSIST_DELAY_MS)) {
+    print(F("restored float param ")); print(float_param); println();
+  }
+  offload.begin(); //start worker threads, if supported
+  am.sendReady(); //let a host that just opened the serial port know that it can send commands now
 #endif
 #endif //BASELINE_MEM
 }
@@ -166,9 +231,14 @@ void loop() {
     return;
   }
 #endif
-  am.update();
+  am_group.update();
 #ifndef DEMO_CLIENT
   timer.tick(am); //text or binary server: tick the timer
+  params.tick(am); //text or binary server: send changed params to binary client
+  persist.tick(); //text or binary server: commit changed params to storage in the background
+  telemetry_rec.tick(am, send_slots); //binary server: sample subscribed telemetry into its conflating send slot
+  send_slots.tick(am); //binary server: send the newest packet of each send slot in turn
+  offload.tick(am); //text or binary server: send responses of finished offloaded commands
 #else //binary client: crank the state machine
   BinaryClientStage *next; if (current_bc_stage && (next = current_bc_stage->update(am))) current_bc_stage = next;
 #endif //DEMO_CLIENT
@@ -0,0 +1,455 @@
+#ifndef AM_DEMO_CMDS_H
+#define AM_DEMO_CMDS_H
+
+//generated by ardumon_gen from demo_cmds.txt (36 commands), do not edit
+//see examples/demo/native/ardumon_gen.cpp
+
+#include <stdint.h>
+#include <string.h>
+
+namespace demo_cmds {
+
+//compare to ArduMon::getCmdHash() on the server
+constexpr uint32_t TABLE_HASH = 0x2cfafabaUL;
+
+//must match the with_code16 template parameter of ArduMon on the server
+constexpr bool CODE16 = false;
+
+//encodes one binary mode packet into a caller supplied buffer: [length] [code(s)] [payload] [checksum]
+//multi-byte values are little endian, as sent by ArduMon on all supported platforms
+struct Frame {
+
+  Frame(char *b, const uint8_t sz) : buf(b), buf_sz(sz), ok(b && sz > 2) {}
+
+  //append a command code in the same format as ArduMon::sendCode()
+  Frame& code(const uint16_t c) {
+    if (c < 0x80 || !CODE16) return put(static_cast<uint8_t>(c));
+    return put(static_cast<uint8_t>((c >> 8) | 0x80)).put(static_cast<uint8_t>(c));
+  }
+
+  template <typename T> Frame& put(const T &v) { return raw(&v, sizeof(T)); }
+
+  Frame& put(const bool v) { return put(static_cast<uint8_t>(v ? 1 : 0)); }
+
+  Frame& put(const char *v) { return raw(v, v ? strlen(v) + 1 : 0); } //including terminating null
+
+  Frame& raw(const void *v, const size_t n) {
+    if (!ok || n > static_cast<size_t>(buf_sz - 1 - len)) { ok = false; return *this; } //reserve the checksum byte
+    memcpy(buf + len, v, n); len += n;
+    return *this;
+  }
+
+  //set the length and checksum and return the packet length, or 0 if it did not fit
+  uint8_t end() {
+    if (!ok) return 0;
+    buf[0] = static_cast<char>(len + 1);
+    uint8_t sum = 0;
+    for (uint8_t i = 0; i < len; i++) sum += static_cast<uint8_t>(buf[i]);
+    buf[len] = static_cast<char>(-sum);
+    return len + 1;
+  }
+
+private:
+  char * const buf;
+  const uint8_t buf_sz;
+  uint8_t len = 1; //first byte is reserved for length
+  bool ok;
+};
+
+//receives values from a response payload with the same API as ArduMon, so either can be passed to the decoders
+struct Reader {
+
+  Reader(const char *payload, const uint8_t n) : ptr(payload), end(payload + n) {}
+
+  template <typename T> Reader& recv(T &v) {
+    if (!ok || static_cast<size_t>(end - ptr) < sizeof(T)) { ok = false; return *this; }
+    memcpy(&v, ptr, sizeof(T)); ptr += sizeof(T);
+    return *this;
+  }
+
+  Reader& recv(bool &v) { uint8_t b = 0; recv(b); v = b != 0; return *this; }
+
+  Reader& recvChar(char &v) { return recv(v); }
+
+  Reader& recv(const char* &v) { //points into the payload
+    const char *p = ptr;
+    while (p < end && *p) p++;
+    if (!ok || p == end) { ok = false; return *this; }
+    v = ptr; ptr = p + 1;
+    return *this;
+  }
+
+  //true iff all values so far were received and the whole payload was consumed
+  bool done() const { return ok && ptr == end; }
+
+  operator bool() const { return ok; }
+
+private:
+  const char *ptr, * const end;
+  bool ok = true;
+};
+
+//gcc (0): str -> i16
+//name | get command code
+constexpr uint16_t GCC = 0;
+inline uint8_t encodeGcc(char *buf, const uint8_t buf_sz, const char* a0) {
+  return Frame(buf, buf_sz).code(GCC).put(a0).end();
+}
+template <typename R> bool decodeGcc(R &r, int16_t &r0) {
+  return r.recv(r0);
+}
+
+//help (1): no args -> no response
+//show commands
+constexpr uint16_t HELP = 1;
+inline uint8_t encodeHelp(char *buf, const uint8_t buf_sz) {
+  return Frame(buf, buf_sz).code(HELP).end();
+}
+
+//quiet (2): bll? -> no response
+//[end_marker] | disable text echo and prompt, optionally enable end of response marker
+constexpr uint16_t QUIET = 2;
+inline uint8_t encodeQuiet(char *buf, const uint8_t buf_sz) {
+  return Frame(buf, buf_sz).code(QUIET).end();
+}
+inline uint8_t encodeQuiet(char *buf, const uint8_t buf_sz, const bool a0) {
+  return Frame(buf, buf_sz).code(QUIET).put(a0).end();
+}
+
+//argc (3): ... -> u08
+//show arg count
+constexpr uint16_t ARGC = 3;
+inline uint8_t encodeArgc(char *buf, const uint8_t buf_sz, const void *more = 0, const uint8_t more_len = 0) {
+  return Frame(buf, buf_sz).code(ARGC).raw(more, more_len).end();
+}
+template <typename R> bool decodeArgc(R &r, uint8_t &r0) {
+  return r.recv(r0);
+}
+
+//ts (4): u08 u08 u08 f32? i16? i16? -> u32 u32 u32
+//hours mins secs [accel [sync_throttle_ms|-1 [bin_response_code]]] | start timer
+constexpr uint16_t TS = 4;
+inline uint8_t encodeTs(char *buf, const uint8_t buf_sz, const uint8_t a0, const uint8_t a1, const uint8_t a2) {
+  return Frame(buf, buf_sz).code(TS).put(a0).put(a1).put(a2).end();
+}
+inline uint8_t encodeTs(char *buf, const uint8_t buf_sz, const uint8_t a0, const uint8_t a1, const uint8_t a2,
+    const float a3) {
+  return Frame(buf, buf_sz).code(TS).put(a0).put(a1).put(a2).put(a3).end();
+}
+inline uint8_t encodeTs(char *buf, const uint8_t buf_sz, const uint8_t a0, const uint8_t a1, const uint8_t a2,
+    const float a3, const int16_t a4) {
+  return Frame(buf, buf_sz).code(TS).put(a0).put(a1).put(a2).put(a3).put(a4).end();
+}
+inline uint8_t encodeTs(char *buf, const uint8_t buf_sz, const uint8_t a0, const uint8_t a1, const uint8_t a2,
+    const float a3, const int16_t a4, const int16_t a5) {
+  return Frame(buf, buf_sz).code(TS).put(a0).put(a1).put(a2).put(a3).put(a4).put(a5).end();
+}
+template <typename R> bool decodeTs(R &r, uint32_t &r0, uint32_t &r1, uint32_t &r2) {
+  return r.recv(r0).recv(r1).recv(r2);
+}
+
+//to (5): no args -> no response
+//stop timer
+constexpr uint16_t TO = 5;
+inline uint8_t encodeTo(char *buf, const uint8_t buf_sz) {
+  return Frame(buf, buf_sz).code(TO).end();
+}
+
+//tg (6): no args -> u32 u32 u32
+//get timer
+constexpr uint16_t TG = 6;
+inline uint8_t encodeTg(char *buf, const uint8_t buf_sz) {
+  return Frame(buf, buf_sz).code(TG).end();
+}
+template <typename R> bool decodeTg(R &r, uint32_t &r0, uint32_t &r1, uint32_t &r2) {
+  return r.recv(r0).recv(r1).recv(r2);
+}
+
+//ec (7): chr -> chr
+//arg | echo char
+constexpr uint16_t EC = 7;
+inline uint8_t encodeEc(char *buf, const uint8_t buf_sz, const char a0) {
+  return Frame(buf, buf_sz).code(EC).put(a0).end();
+}
+template <typename R> bool decodeEc(R &r, char &r0) {
+  return r.recvChar(r0);
+}
+
+//es (8): str -> str
+//arg | echo str
+constexpr uint16_t ES = 8;
+inline uint8_t encodeEs(char *buf, const uint8_t buf_sz, const char* a0) {
+  return Frame(buf, buf_sz).code(ES).put(a0).end();
+}
+template <typename R> bool decodeEs(R &r, const char* &r0) {
+  return r.recv(r0);
+}
+
+//eb (9): bll -> bll
+//arg [style [upper_case]] | echo bool
+constexpr uint16_t EB = 9;
+inline uint8_t encodeEb(char *buf, const uint8_t buf_sz, const bool a0) {
+  return Frame(buf, buf_sz).code(EB).put(a0).end();
+}
+template <typename R> bool decodeEb(R &r, bool &r0) {
+  return r.recv(r0);
+}
+
+//eu8 (10): u08 -> u08
+//arg [hex [width [pad_zero [pad_right]]]] | echo uint8
+constexpr uint16_t EU8 = 10;
+inline uint8_t encodeEu8(char *buf, const uint8_t buf_sz, const uint8_t a0) {
+  return Frame(buf, buf_sz).code(EU8).put(a0).end();
+}
+template <typename R> bool decodeEu8(R &r, uint8_t &r0) {
+  return r.recv(r0);
+}
+
+//es8 (11): i08 -> i08
+//arg [hex [width [pad_zero [pad_right]]]] | echo int8
+constexpr uint16_t ES8 = 11;
+inline uint8_t encodeEs8(char *buf, const uint8_t buf_sz, const int8_t a0) {
+  return Frame(buf, buf_sz).code(ES8).put(a0).end();
+}
+template <typename R> bool decodeEs8(R &r, int8_t &r0) {
+  return r.recv(r0);
+}
+
+//eu16 (12): u16 -> u16
+//arg [hex [width [pad_zero [pad_right]]]] | echo uint16
+constexpr uint16_t EU16 = 12;
+inline uint8_t encodeEu16(char *buf, const uint8_t buf_sz, const uint16_t a0) {
+  return Frame(buf, buf_sz).code(EU16).put(a0).end();
+}
+template <typename R> bool decodeEu16(R &r, uint16_t &r0) {
+  return r.recv(r0);
+}
+
+//es16 (13): i16 -> i16
+//arg [hex [width [pad_zero [pad_right]]]] | echo int16
+constexpr uint16_t ES16 = 13;
+inline uint8_t encodeEs16(char *buf, const uint8_t buf_sz, const int16_t a0) {
+  return Frame(buf, buf_sz).code(ES16).put(a0).end();
+}
+template <typename R> bool decodeEs16(R &r, int16_t &r0) {
+  return r.recv(r0);
+}
+
+//eu32 (14): u32 -> u32
+//arg [hex [width [pad_zero [pad_right]]]] | echo uint32
+constexpr uint16_t EU32 = 14;
+inline uint8_t encodeEu32(char *buf, const uint8_t buf_sz, const uint32_t a0) {
+  return Frame(buf, buf_sz).code(EU32).put(a0).end();
+}
+template <typename R> bool decodeEu32(R &r, uint32_t &r0) {
+  return r.recv(r0);
+}
+
+//es32 (15): i32 -> i32
+//arg [hex [width [pad_zero [pad_right]]]] | echo int32
+constexpr uint16_t ES32 = 15;
+inline uint8_t encodeEs32(char *buf, const uint8_t buf_sz, const int32_t a0) {
+  return Frame(buf, buf_sz).code(ES32).put(a0).end();
+}
+template <typename R> bool decodeEs32(R &r, int32_t &r0) {
+  return r.recv(r0);
+}
+
+//eu64 (16): u64 -> u64
+//arg [hex [width [pad_zero [pad_right]]]] | echo uint64
+constexpr uint16_t EU64 = 16;
+inline uint8_t encodeEu64(char *buf, const uint8_t buf_sz, const uint64_t a0) {
+  return Frame(buf, buf_sz).code(EU64).put(a0).end();
+}
+template <typename R> bool decodeEu64(R &r, uint64_t &r0) {
+  return r.recv(r0);
+}
+
+//es64 (17): i64 -> i64
+//arg [hex [width [pad_zero [pad_right]]]] | echo int64
+constexpr uint16_t ES64 = 17;
+inline uint8_t encodeEs64(char *buf, const uint8_t buf_sz, const int64_t a0) {
+  return Frame(buf, buf_sz).code(ES64).put(a0).end();
+}
+template <typename R> bool decodeEs64(R &r, int64_t &r0) {
+  return r.recv(r0);
+}
+
+//ef (18): f32 -> f32
+//arg [scientific [precision [width]]] | echo float
+constexpr uint16_t EF = 18;
+inline uint8_t encodeEf(char *buf, const uint8_t buf_sz, const float a0) {
+  return Frame(buf, buf_sz).code(EF).put(a0).end();
+}
+template <typename R> bool decodeEf(R &r, float &r0) {
+  return r.recv(r0);
+}
+
+//ed (19): f64 -> f64
+//arg [scientific [precision [width]]] | echo double
+constexpr uint16_t ED = 19;
+inline uint8_t encodeEd(char *buf, const uint8_t buf_sz, const double a0) {
+  return Frame(buf, buf_sz).code(ED).put(a0).end();
+}
+template <typename R> bool decodeEd(R &r, double &r0) {
+  return r.recv(r0);
+}
+
+//em (20): str ... -> ...
+//format_string args... | echo multiple args based on format
+constexpr uint16_t EM = 20;
+inline uint8_t encodeEm(char *buf, const uint8_t buf_sz, const char* a0,
+    const void *more = 0, const uint8_t more_len = 0) {
+  return Frame(buf, buf_sz).code(EM).put(a0).raw(more, more_len).end();
+}
+
+//sfp (21): f32 -> no response
+//arg | set float param
+constexpr uint16_t SFP = 21;
+inline uint8_t encodeSfp(char *buf, const uint8_t buf_sz, const float a0) {
+  return Frame(buf, buf_sz).code(SFP).put(a0).end();
+}
+
+//gfp (22): no args -> f32
+//get float param
+constexpr uint16_t GFP = 22;
+inline uint8_t encodeGfp(char *buf, const uint8_t buf_sz) {
+  return Frame(buf, buf_sz).code(GFP).end();
+}
+template <typename R> bool decodeGfp(R &r, float &r0) {
+  return r.recv(r0);
+}
+
+//fp (23) group
+//float param commands
+constexpr uint16_t FP = 23;
+
+//fp.set (23.0): f32 -> no response
+//arg | set float param
+constexpr uint16_t FP_SET = 0;
+inline uint8_t encodeFpSet(char *buf, const uint8_t buf_sz, const float a0) {
+  return Frame(buf, buf_sz).code(FP).code(FP_SET).put(a0).end();
+}
+
+//fp.get (23.1): no args -> f32
+//get float param
+constexpr uint16_t FP_GET = 1;
+inline uint8_t encodeFpGet(char *buf, const uint8_t buf_sz) {
+  return Frame(buf, buf_sz).code(FP).code(FP_GET).end();
+}
+template <typename R> bool decodeFpGet(R &r, float &r0) {
+  return r.recv(r0);
+}
+
+//quit (24): no args -> no response
+//quit
+constexpr uint16_t QUIT = 24;
+inline uint8_t encodeQuit(char *buf, const uint8_t buf_sz) {
+  return Frame(buf, buf_sz).code(QUIT).end();
+}
+
+//cmp (25): u08 ... -> u08 ...
+//binary only | run multiple commands from one packet
+constexpr uint16_t CMP = 25;
+inline uint8_t encodeCmp(char *buf, const uint8_t buf_sz, const uint8_t a0,
+    const void *more = 0, const uint8_t more_len = 0) {
+  return Frame(buf, buf_sz).code(CMP).put(a0).raw(more, more_len).end();
+}
+template <typename R> bool decodeCmp(R &r, uint8_t &r0) {
+  return r.recv(r0);
+}
+
+//pg (26): u08 bll? -> u08 u08 ...
+//id [watch] | get param, in binary mode also send changes iff watch (default 1)
+constexpr uint16_t PG = 26;
+inline uint8_t encodePg(char *buf, const uint8_t buf_sz, const uint8_t a0) {
+  return Frame(buf, buf_sz).code(PG).put(a0).end();
+}
+inline uint8_t encodePg(char *buf, const uint8_t buf_sz, const uint8_t a0, const bool a1) {
+  return Frame(buf, buf_sz).code(PG).put(a0).put(a1).end();
+}
+template <typename R> bool decodePg(R &r, uint8_t &r0, uint8_t &r1) {
+  return r.recv(r0).recv(r1);
+}
+
+//ssq (27): u32 -> u08 u64
+//binary only | n | sum of squares below n, computed on a worker thread
+constexpr uint16_t SSQ = 27;
+inline uint8_t encodeSsq(char *buf, const uint8_t buf_sz, const uint32_t a0) {
+  return Frame(buf, buf_sz).code(SSQ).put(a0).end();
+}
+template <typename R> bool decodeSsq(R &r, uint8_t &r0, uint64_t &r1) {
+  return r.recv(r0).recv(r1);
+}
+
+//stats (28): no args -> u32 u32 u32 u32 u32 u32 u16 u16
+//get performance counters
+constexpr uint16_t STATS = 28;
+inline uint8_t encodeStats(char *buf, const uint8_t buf_sz) {
+  return Frame(buf, buf_sz).code(STATS).end();
+}
+template <typename R> bool decodeStats(R &r, uint32_t &r0, uint32_t &r1, uint32_t &r2, uint32_t &r3, uint32_t &r4,
+    uint32_t &r5, uint16_t &r6, uint16_t &r7) {
+  return r.recv(r0).recv(r1).recv(r2).recv(r3).recv(r4).recv(r5).recv(r6).recv(r7);
+}
+
+//ready (29): no args -> str
+//respond ready
+constexpr uint16_t READY = 29;
+inline uint8_t encodeReady(char *buf, const uint8_t buf_sz) {
+  return Frame(buf, buf_sz).code(READY).end();
+}
+template <typename R> bool decodeReady(R &r, const char* &r0) {
+  return r.recv(r0);
+}
+
+//hash (30): no args -> u32
+//get command table hash
+constexpr uint16_t HASH = 30;
+inline uint8_t encodeHash(char *buf, const uint8_t buf_sz) {
+  return Frame(buf, buf_sz).code(HASH).end();
+}
+template <typename R> bool decodeHash(R &r, uint32_t &r0) {
+  return r.recv(r0);
+}
+
+//sum (31): ... -> u16 i32
+//args... | sum any number of int32 args
+constexpr uint16_t SUM = 31;
+inline uint8_t encodeSum(char *buf, const uint8_t buf_sz, const void *more = 0, const uint8_t more_len = 0) {
+  return Frame(buf, buf_sz).code(SUM).raw(more, more_len).end();
+}
+template <typename R> bool decodeSum(R &r, uint16_t &r0, int32_t &r1) {
+  return r.recv(r0).recv(r1);
+}
+
+//tm (32): u32 u16? -> u08 u32 ...
+//mask [period_ms] | get telemetry, in binary mode also every period_ms
+constexpr uint16_t TM = 32;
+inline uint8_t encodeTm(char *buf, const uint8_t buf_sz, const uint32_t a0) {
+  return Frame(buf, buf_sz).code(TM).put(a0).end();
+}
+inline uint8_t encodeTm(char *buf, const uint8_t buf_sz, const uint32_t a0, const uint16_t a1) {
+  return Frame(buf, buf_sz).code(TM).put(a0).put(a1).end();
+}
+template <typename R> bool decodeTm(R &r, uint8_t &r0, uint32_t &r1) {
+  return r.recv(r0).recv(r1);
+}
+
+//bench (33): u16? -> u16 u32 u32 u32 u32 u32 u32 u32
+//[n] | time codec paths n times (default 100), see getBenchHandler()
+constexpr uint16_t BENCH = 33;
+inline uint8_t encodeBench(char *buf, const uint8_t buf_sz) {
+  return Frame(buf, buf_sz).code(BENCH).end();
+}
+inline uint8_t encodeBench(char *buf, const uint8_t buf_sz, const uint16_t a0) {
+  return Frame(buf, buf_sz).code(BENCH).put(a0).end();
+}
+template <typename R> bool decodeBench(R &r, uint16_t &r0, uint32_t &r1, uint32_t &r2, uint32_t &r3, uint32_t &r4,
+    uint32_t &r5, uint32_t &r6, uint32_t &r7) {
+  return r.recv(r0).recv(r1).recv(r2).recv(r3).recv(r4).recv(r5).recv(r6).recv(r7);
+}
+
+} //namespace demo_cmds
+
+#endif //AM_DEMO_CMDS_H
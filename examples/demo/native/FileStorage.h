@@ -0,0 +1,73 @@
+#ifndef AM_FILE_STORAGE_H
+#define AM_FILE_STORAGE_H
+
+/**
+ * ArduMon: Yet another Arduino serial command library.
+ *
+ * See https://github.com/martyvona/ArduMon/blob/main/README.md
+ *
+ * This is a file backed stand-in for EEPROM or flash, used by ardumon_server --persist to test ArduMonPersist.h
+ * natively.  A new file is filled with 0xff bytes, like erased flash.  Each byte is written through to the file
+ * immediately, so the file always has the contents that the device storage would have if power was lost.
+ *
+ * Copyright 2025 Marsette A. Vona (martyvona@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+template <uint16_t sz = 1024> class FileStorage : public ArduMonStorage {
+public:
+
+  ~FileStorage() { close(); }
+
+  //open or create the file at path; returns false with errno set on error
+  bool open(const char *path) {
+    close();
+    if ((fd = ::open(path, O_RDWR | O_CREAT, 0644)) < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) return false;
+    for (off_t i = st.st_size; i < sz; i++) { //erase any bytes that the file does not have yet
+      const uint8_t v = 0xff;
+      if (pwrite(fd, &v, 1, i) != 1) return false;
+    }
+    return true;
+  }
+
+  void close() { if (fd >= 0) ::close(fd); fd = -1; }
+
+  uint16_t size() { return sz; }
+
+  uint8_t read(const uint16_t addr) {
+    uint8_t v = 0xff;
+    if (fd < 0 || addr >= sz || pread(fd, &v, 1, addr) != 1) return 0xff;
+    return v;
+  }
+
+  void write(const uint16_t addr, const uint8_t v) {
+    if (fd >= 0 && addr < sz && pwrite(fd, &v, 1, addr) == 1) ++num_writes;
+  }
+
+  uint32_t getNumWrites() { return num_writes; }
+
+private:
+
+  int fd = -1;
+  uint32_t num_writes = 0;
+};
+
+#endif //AM_FILE_STORAGE_H
@@ -0,0 +1,168 @@
+#ifndef AM_SERIAL_PORT_H
+#define AM_SERIAL_PORT_H
+
+/**
+ * ArduMon: Yet another Arduino serial command library.
+ *
+ * See https://github.com/martyvona/ArduMon/blob/main/README.md
+ *
+ * This is the serial port backend of the native client, used when ardumon_client is connected to a serial port file
+ * rather than a UNIX socket.
+ *
+ * Polling a nonblocking serial port from the protocol loop with a sleep between polls adds up to the sleep time to
+ * every response.  Instead a reader thread blocks in poll() on the port and reads each burst of bytes as soon as it
+ * arrives into one chunk of a single producer single consumer ring, stamped with its arrival time in micros().  The
+ * protocol loop takes bytes from the ring without locking, and can sleep in wait() until the next chunk arrives
+ * rather than for a fixed time.  The mutex and condition variable are only used to wake the protocol loop, not to hand
+ * off data.  Writes are batched by the caller and block in poll() while the port is full, instead of sleeping.
+ *
+ * lowLatency() also asks the driver to skip its own receive latency timer, e.g. the default 16ms of FTDI adapters on
+ * Linux, where supported.  Then the per command turnaround is limited by the adapter and the device, not the host.
+ *
+ * This also works with a pseudo terminal, see the --pty option of ardumon_server.
+ *
+ * Copyright 2025 Marsette A. Vona (martyvona@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <poll.h>
+#include <sys/ioctl.h>
+#ifdef __linux__
+#include <linux/serial.h>
+#endif
+
+template <size_t num_chunks = 64, size_t chunk_sz = 256> class SerialPort {
+public:
+
+  //ask the driver of serial port fd to deliver received bytes without waiting for its latency timer
+  //returns false if that is not supported, e.g. on OS X or for a pseudo terminal, which is harmless
+  static bool lowLatency(const int fd) {
+#if defined(__linux__) && defined(ASYNC_LOW_LATENCY)
+    struct serial_struct ss;
+    if (ioctl(fd, TIOCGSERIAL, &ss) != 0) return false;
+    ss.flags |= ASYNC_LOW_LATENCY;
+    return ioctl(fd, TIOCSSERIAL, &ss) == 0;
+#else
+    return false;
+#endif
+  }
+
+  ~SerialPort() { stop(); }
+
+  //start the reader thread on nonblocking serial port fd
+  void start(const int _fd) {
+    if (running()) return;
+    fd = _fd; err = 0; stopping = false;
+    reader = std::thread([this]() { readLoop(); });
+  }
+
+  //stop and join the reader thread; bytes already received remain available to read()
+  void stop() {
+    if (!running()) return;
+    stopping = true;
+    reader.join();
+  }
+
+  bool running() { return reader.joinable(); }
+
+  //errno of the error that stopped the reader thread, 0 if none
+  int error() { return err; }
+
+  //take up to n received bytes without blocking; returns the number taken, or -1 if there are none and the reader
+  //thread stopped on an error
+  //if arrival_us is not 0 it is set to the micros() at which the first byte taken was received
+  int read(uint8_t *buf, const size_t n, uint64_t *arrival_us = 0) {
+    size_t nr = 0, h = head.load(std::memory_order_relaxed);
+    while (nr < n && h != tail.load(std::memory_order_acquire)) {
+      const Chunk &c = chunks[h % num_chunks];
+      if (nr == 0 && arrival_us) *arrival_us = c.us;
+      const size_t k = std::min(n - nr, c.len - offset);
+      memcpy(buf + nr, c.data + offset, k);
+      nr += k; offset += k;
+      if (offset == c.len) { offset = 0; head.store(++h, std::memory_order_release); }
+    }
+    return nr == 0 && err ? -1 : static_cast<int>(nr);
+  }
+
+  //block until a chunk is available to read(), the reader thread stops, or timeout_us elapses
+  void wait(const uint32_t timeout_us) {
+    std::unique_lock<std::mutex> lock(mutex);
+    arrived.wait_for(lock, std::chrono::microseconds(timeout_us), [this]() { return available() || err != 0; });
+  }
+
+  bool available() { return head.load(std::memory_order_relaxed) != tail.load(std::memory_order_acquire); }
+
+  //write all n bytes, blocking in poll() whenever the port is full; returns false with errno set on error
+  bool write(const uint8_t *buf, const size_t n) {
+    for (size_t nw = 0; nw < n; ) {
+      const ssize_t ret = ::write(fd, buf + nw, n - nw);
+      if (ret >= 0) { nw += ret; continue; }
+      if (errno != EAGAIN) return false;
+      struct pollfd p = { fd, POLLOUT, 0 };
+      if (poll(&p, 1, POLL_MS) < 0 && errno != EINTR) return false;
+    }
+    return true;
+  }
+
+private:
+
+  static const int POLL_MS = 100; //how often the reader thread checks if it should stop
+
+  struct Chunk { uint64_t us; size_t len; uint8_t data[chunk_sz]; };
+
+  void readLoop() {
+    while (!stopping) {
+      const size_t t = tail.load(std::memory_order_relaxed);
+      if (t - head.load(std::memory_order_acquire) == num_chunks) { //ring full, leave the bytes in the driver
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        continue;
+      }
+      struct pollfd p = { fd, POLLIN, 0 };
+      const int ret = poll(&p, 1, POLL_MS);
+      if (ret < 0 && errno == EINTR) continue;
+      if (ret < 0) { fail(errno); return; }
+      if (ret == 0) continue;
+      Chunk &c = chunks[t % num_chunks];
+      const ssize_t nr = ::read(fd, c.data, chunk_sz);
+      if (nr < 0 && errno == EAGAIN) continue;
+      if (nr <= 0) { fail(nr < 0 ? errno : EIO); return; } //0 means the port hung up
+      c.us = micros(); c.len = nr;
+      tail.store(t + 1, std::memory_order_release);
+      notify();
+    }
+  }
+
+  void fail(const int e) { err = e; notify(); }
+
+  //taking the lock before notifying ensures that a wait() which just found nothing available is already waiting
+  void notify() { { std::lock_guard<std::mutex> lock(mutex); } arrived.notify_one(); }
+
+  int fd = -1;
+  std::thread reader;
+  std::atomic<bool> stopping{false};
+  std::atomic<int> err{0};
+
+  Chunk chunks[num_chunks];
+  std::atomic<size_t> head{0}, tail{0}; //chunk counts consumed and produced, the ring index is modulo num_chunks
+  size_t offset = 0; //bytes already consumed from the head chunk
+
+  std::mutex mutex;
+  std::condition_variable arrived;
+};
+
+#endif //AM_SERIAL_PORT_H
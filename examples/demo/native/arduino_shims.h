@@ -41,6 +41,12 @@ uint64_t millis() {
   return std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count();
 }
 
+uint64_t micros() {
+  static const auto start = std::chrono::steady_clock::now();
+  auto now = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(now - start).count();
+}
+
 void delayMicroseconds(uint16_t us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
 
 #endif //ARDUINO_SHIMS_H
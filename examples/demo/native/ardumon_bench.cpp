@@ -0,0 +1,134 @@
+/**
+ * ArduMon: Yet another Arduino serial command library.
+ *
+ * See https://github.com/martyvona/ArduMon/blob/main/README.md
+ *
+ * This is a native microbenchmark of the text scanning and checksum kernels scanSpecial() and sum8() in ArduMon.h,
+ * which are selected at compile time, see the comment at the top of ArduMon.h.  It times them through the public API
+ * on in-memory streams, so that serial I/O does not dominate:
+ * * cooked send: send() a 2000 char string in text mode, which scans it for chars that need quoting or escaping
+ * * text command: receive, tokenize, and dispatch a 1000 char command line
+ * * binary packet: receive, checksum, and dispatch a 127 byte packet
+ *
+ * Each result is the fastest of several rounds, since other load on the host can only add time.  Building it against
+ * an older ArduMon.h gives a baseline to compare with.
+ *
+ * bench-native.sh builds and runs it once for each kernel variant; the build lines are
+ *   g++ --std=c++11 -O3 -I../../../src -o ardumon_bench ardumon_bench.cpp #SSE2 on x86, NEON on 64 bit ARM
+ *   g++ --std=c++11 -O3 -I../../../src -U__SSE2__ -U__ARM_NEON -o ardumon_bench ardumon_bench.cpp #SWAR
+ *   g++ --std=c++11 -O3 -I../../../src -DARDUMON_NO_SIMD -o ardumon_bench ardumon_bench.cpp #bytewise
+ *
+ * Copyright 2025 Marsette A. Vona (martyvona@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <chrono>
+
+#include "arduino_shims.h"
+
+#include <ArduMon.h>
+
+#if defined(ARDUMON_SSE2)
+#define KERNELS "SSE2"
+#elif defined(ARDUMON_NEON)
+#define KERNELS "NEON"
+#elif defined(ARDUMON_SWAR)
+#define KERNELS "SWAR"
+#else
+#define KERNELS "bytewise"
+#endif
+
+//replays the bytes of in each time it is rewound, and discards all written bytes
+class MemStream : public ArduMonStream {
+public:
+  std::string in; size_t pos = 0; uint64_t written = 0;
+  void rewind() { pos = 0; }
+  int16_t available() { return static_cast<int16_t>(in.size() - pos); }
+  int16_t read() { return pos < in.size() ? static_cast<uint8_t>(in[pos++]) : -1; }
+  int16_t peek() { return pos < in.size() ? static_cast<uint8_t>(in[pos]) : -1; }
+  int16_t availableForWrite() { return 0x7fff; }
+  uint16_t write(uint8_t) { ++written; return 1; }
+};
+
+using TextAM = ArduMon<4, 1024, 16, false, false, false, false, true>;
+using BinAM = ArduMon<4, 128, 16, false, false, false, true, false>;
+
+static uint32_t num_handled = 0;
+
+//mean nanoseconds per call of f() over n calls, the fastest of ROUNDS rounds to filter out other load on the host
+static const int ROUNDS = 25;
+template <typename F> static double timeNS(const uint32_t n, const F &f) {
+  double best = 0;
+  for (int r = 0; r < ROUNDS; r++) {
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < n; i++) f();
+    const auto end = std::chrono::steady_clock::now();
+    const double ns = std::chrono::duration<double, std::nano>(end - start).count() / n;
+    if (r == 0 || ns < best) best = ns;
+  }
+  return best;
+}
+
+static void report(const char *what, const double ns) { printf("  %-28s %8.2fus\n", what, ns / 1000); }
+
+int main(int argc, const char **argv) {
+
+  const uint32_t n = argc > 1 ? static_cast<uint32_t>(atol(argv[1])) : 2000;
+
+  printf("ArduMon %s kernels, best of %d rounds of %u runs\n", KERNELS, ROUNDS, static_cast<unsigned>(n));
+
+  srand(1);
+  const auto text = [](const size_t len) { //lowercase words separated by single spaces
+    std::string s;
+    while (s.size() < len) s += (s.size() % 8 == 7 && s.size() + 1 < len) ? ' ' : static_cast<char>('a' + rand() % 26);
+    return s;
+  };
+
+  { //cooked send
+    MemStream s; TextAM am(&s);
+    const std::string str = text(2000);
+    report("cooked send, 2000 chars", timeNS(n, [&]() { am.send(str.c_str()); am.sendCRLF(true); }));
+  }
+
+  { //text command
+    MemStream s; TextAM am(&s);
+    am.addCmd([](TextAM &am) -> bool { ++num_handled; return am.skip(am.argc()).endHandler(); }, "cmd");
+    s.in = "cmd " + text(995) + "\n";
+    const uint32_t before = num_handled;
+    report("text command, 1000 chars", timeNS(n, [&]() { s.rewind(); am.update(); }));
+    if (num_handled - before != ROUNDS * n) { printf("ERROR: text command failed\n"); return 1; }
+  }
+
+  { //binary packet
+    MemStream s; BinAM am(&s);
+    am.addCmd([](BinAM &am) -> bool { ++num_handled; return am.skip(am.argc()).endHandler(); }, "cmd", 1);
+    std::string &p = s.in;
+    p.push_back(static_cast<char>(127)); p.push_back(1);
+    for (int i = 0; i < 124; i++) p.push_back(static_cast<char>(rand()));
+    uint8_t sum = 0; for (const char c : p) sum += static_cast<uint8_t>(c);
+    p.push_back(static_cast<char>(-sum));
+    const uint32_t before = num_handled;
+    report("binary packet, 127 bytes", timeNS(n, [&]() { s.rewind(); am.update(); }));
+    if (num_handled - before != ROUNDS * n) { printf("ERROR: binary packet failed\n"); return 1; }
+  }
+
+  return 0;
+}
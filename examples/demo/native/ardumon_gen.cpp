@@ -0,0 +1,294 @@
+/**
+ * ArduMon: Yet another Arduino serial command library.
+ *
+ * See https://github.com/martyvona/ArduMon/blob/main/README.md
+ *
+ * ardumon_gen reads a command description file, see cmd_desc.h, and generates a C++ header for binary mode clients of
+ * the described server.  The header has no dependencies other than <stdint.h> and <string.h>, so it can be used on
+ * a host or on an Arduino.  It contains, in a namespace named for the description file unless --namespace is given:
+ *
+ * * TABLE_HASH, to compare with ArduMon::getCmdHash() on the server
+ * * a constexpr code for each command, e.g. FP and FP_GET for subcommand get of group fp
+ * * for each command other than a group, an encoder function, e.g. encodeSfp(buf, buf_sz, value), which writes a
+ *   complete packet into buf including the command code(s), length, and checksum, and returns its length, or 0 if it
+ *   does not fit; the packet can be sent with ArduMon::sendFramed() or written directly to a stream; one overload is
+ *   generated for each number of optional arguments, and commands with a trailing ... take a final raw byte array
+ * * for each command with a described response, a decoder function template, e.g. decodeGfp(r, value), which receives
+ *   the response fields from r; r is either ArduMon itself, in a handler for the response packet, or a Reader over
+ *   the response payload; a decoder does not check that the whole response was received, so a handler must still
+ *   call ArduMon::endHandler()
+ *
+ * Usage: ardumon_gen [--namespace=name] [--code16] desc_file [out_file]
+ *
+ * --code16 must match the with_code16 template parameter of the ArduMon server.  The header is written to stdout if
+ * out_file is not given.
+ *
+ * Copyright 2025 Marsette A. Vona (martyvona@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+#include "cmd_desc.h"
+
+void usage() {
+  std::cerr << "USAGE: ardumon_gen [--namespace=name] [--code16] desc_file [out_file]\n";
+  exit(1);
+}
+
+//e.g. "fp.get" -> "FP_GET"
+std::string constName(const std::string &name) {
+  std::string ret;
+  for (const char c : name) ret += c == '.' ? '_' : static_cast<char>(toupper(c));
+  return ret;
+}
+
+//e.g. "fp.get" -> "FpGet", "set_pid" -> "SetPid"
+std::string camelName(const std::string &name) {
+  std::string ret;
+  bool up = true;
+  for (const char c : name) {
+    if (c == '.' || c == '_') { up = true; continue; }
+    ret += up ? static_cast<char>(toupper(c)) : c;
+    up = false;
+  }
+  return ret;
+}
+
+//e.g. "path/to/demo_cmds.txt" -> "demo_cmds.txt"
+std::string baseName(const std::string &path) {
+  const size_t slash = path.find_last_of("/\\");
+  return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+//e.g. "path/to/demo_cmds.txt" -> "demo_cmds"
+std::string stem(const std::string &path) {
+  const std::string base = baseName(path);
+  return base.substr(0, base.find('.'));
+}
+
+std::string typeList(const CmdDesc::Types &types) {
+  std::string ret;
+  for (size_t i = 0; i < types.types.size(); i++) {
+    if (i > 0) ret += " ";
+    ret += CmdDesc::info(types.types[i]).name;
+    if (i >= types.num_required) ret += "?";
+  }
+  if (types.more) ret += ret.empty() ? "..." : " ...";
+  return ret;
+}
+
+//the fixed part of the generated header: packet encoder and payload reader used by the generated functions
+const char *PREAMBLE = R"(
+//encodes one binary mode packet into a caller supplied buffer: [length] [code(s)] [payload] [checksum]
+//multi-byte values are little endian, as sent by ArduMon on all supported platforms
+struct Frame {
+
+  Frame(char *b, const uint8_t sz) : buf(b), buf_sz(sz), ok(b && sz > 2) {}
+
+  //append a command code in the same format as ArduMon::sendCode()
+  Frame& code(const uint16_t c) {
+    if (c < 0x80 || !CODE16) return put(static_cast<uint8_t>(c));
+    return put(static_cast<uint8_t>((c >> 8) | 0x80)).put(static_cast<uint8_t>(c));
+  }
+
+  template <typename T> Frame& put(const T &v) { return raw(&v, sizeof(T)); }
+
+  Frame& put(const bool v) { return put(static_cast<uint8_t>(v ? 1 : 0)); }
+
+  Frame& put(const char *v) { return raw(v, v ? strlen(v) + 1 : 0); } //including terminating null
+
+  Frame& raw(const void *v, const size_t n) {
+    if (!ok || n > static_cast<size_t>(buf_sz - 1 - len)) { ok = false; return *this; } //reserve the checksum byte
+    memcpy(buf + len, v, n); len += n;
+    return *this;
+  }
+
+  //set the length and checksum and return the packet length, or 0 if it did not fit
+  uint8_t end() {
+    if (!ok) return 0;
+    buf[0] = static_cast<char>(len + 1);
+    uint8_t sum = 0;
+    for (uint8_t i = 0; i < len; i++) sum += static_cast<uint8_t>(buf[i]);
+    buf[len] = static_cast<char>(-sum);
+    return len + 1;
+  }
+
+private:
+  char * const buf;
+  const uint8_t buf_sz;
+  uint8_t len = 1; //first byte is reserved for length
+  bool ok;
+};
+
+//receives values from a response payload with the same API as ArduMon, so either can be passed to the decoders
+struct Reader {
+
+  Reader(const char *payload, const uint8_t n) : ptr(payload), end(payload + n) {}
+
+  template <typename T> Reader& recv(T &v) {
+    if (!ok || static_cast<size_t>(end - ptr) < sizeof(T)) { ok = false; return *this; }
+    memcpy(&v, ptr, sizeof(T)); ptr += sizeof(T);
+    return *this;
+  }
+
+  Reader& recv(bool &v) { uint8_t b = 0; recv(b); v = b != 0; return *this; }
+
+  Reader& recvChar(char &v) { return recv(v); }
+
+  Reader& recv(const char* &v) { //points into the payload
+    const char *p = ptr;
+    while (p < end && *p) p++;
+    if (!ok || p == end) { ok = false; return *this; }
+    v = ptr; ptr = p + 1;
+    return *this;
+  }
+
+  //true iff all values so far were received and the whole payload was consumed
+  bool done() const { return ok && ptr == end; }
+
+  operator bool() const { return ok; }
+
+private:
+  const char *ptr, * const end;
+  bool ok = true;
+};
+)";
+
+//a function signature with the given parameters, wrapped to keep lines under 120 characters
+std::string signature(const std::string &start, const std::vector<std::string> &params) {
+  std::string ret = start + "(", line = ret;
+  for (size_t i = 0; i < params.size(); i++) {
+    const std::string p = params[i] + (i + 1 < params.size() ? "," : ")");
+    if (i > 0 && line.length() + p.length() > 118) { ret += "\n    "; line = "    "; }
+    else if (i > 0) { ret += " "; line += " "; }
+    ret += p; line += p;
+  }
+  return params.empty() ? ret + ")" : ret;
+}
+
+void genCmd(std::ostream &o, const CmdDesc &cmd) {
+
+  const std::string cn = constName(cmd.name), camel = camelName(cmd.name);
+
+  o << "\n//" << cmd.name << " (";
+  for (size_t i = 0; i < cmd.path.size(); i++) o << (i > 0 ? "." : "") << cmd.path[i];
+  o << ")";
+  if (cmd.group) o << " group";
+  else o << ": " << (cmd.args.types.empty() && !cmd.args.more ? "no args" : typeList(cmd.args))
+         << " -> " << (cmd.resp.types.empty() && !cmd.resp.more ? "no response" : typeList(cmd.resp));
+  if (!cmd.description.empty()) o << "\n//" << cmd.description;
+  o << "\nconstexpr uint16_t " << cn << " = " << cmd.code() << ";\n";
+
+  if (cmd.group) return;
+
+  //the codes to write, outermost group first
+  std::string codes;
+  for (size_t i = 1; i <= cmd.path.size(); i++) {
+    std::string prefix = cmd.name;
+    for (size_t j = cmd.path.size(); j > i; j--) prefix.resize(prefix.rfind('.'));
+    codes += ".code(" + constName(prefix) + ")";
+  }
+
+  //one overload for each number of optional arguments
+  const CmdDesc::Types &args = cmd.args;
+  for (size_t n = args.num_required; n <= args.types.size(); n++) {
+    std::vector<std::string> params = { "char *buf", "const uint8_t buf_sz" };
+    for (size_t i = 0; i < n; i++) {
+      const std::string c_type = CmdDesc::info(args.types[i]).c_type;
+      params.push_back((args.types[i] == CmdDesc::Type::STR ? c_type : "const " + c_type) + " a" + std::to_string(i));
+    }
+    if (args.more) params.push_back("const void *more = 0, const uint8_t more_len = 0");
+    o << signature("inline uint8_t encode" + camel, params) << " {\n  return Frame(buf, buf_sz)" << codes;
+    for (size_t i = 0; i < n; i++) o << ".put(a" << i << ")";
+    if (args.more) o << ".raw(more, more_len)";
+    o << ".end();\n}\n";
+  }
+
+  //optional response fields are not decoded, the handler can check the payload length and receive them itself
+  const CmdDesc::Types &resp = cmd.resp;
+  if (resp.num_required == 0) return;
+  std::vector<std::string> params = { "R &r" };
+  for (size_t i = 0; i < resp.num_required; i++) {
+    params.push_back(std::string(CmdDesc::info(resp.types[i]).c_type) + " &r" + std::to_string(i));
+  }
+  o << signature("template <typename R> bool decode" + camel, params) << " {\n  return r";
+  for (size_t i = 0; i < resp.num_required; i++) {
+    o << (resp.types[i] == CmdDesc::Type::CHR ? ".recvChar(r" : ".recv(r") << i << ")";
+  }
+  o << ";\n}\n";
+}
+
+int main(int argc, const char **argv) {
+
+  std::string ns, in_path, out_path;
+  bool code16 = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--namespace=", 12) == 0) ns = argv[i] + 12;
+    else if (strcmp(argv[i], "--code16") == 0) code16 = true;
+    else if (argv[i][0] == '-') usage();
+    else if (in_path.empty()) in_path = argv[i];
+    else if (out_path.empty()) out_path = argv[i];
+    else usage();
+  }
+
+  if (in_path.empty()) usage();
+  if (ns.empty()) ns = stem(in_path);
+
+  std::ifstream in(in_path);
+  if (!in) { std::cerr << "ERROR: cannot open " << in_path << "\n"; return 1; }
+
+  std::vector<CmdDesc> cmds;
+  const std::string err = parseCmdDescs(in, cmds);
+  if (!err.empty()) { std::cerr << "ERROR: " << in_path << " " << err << "\n"; return 1; }
+
+  for (const CmdDesc &cmd : cmds) {
+    for (const uint16_t c : cmd.path) {
+      if (!code16 && c > 0xff) { std::cerr << "ERROR: code of " << cmd.name << " requires --code16\n"; return 1; }
+    }
+  }
+
+  const std::string guard = "AM_" + constName(ns) + "_H";
+  char hash[16]; snprintf(hash, sizeof(hash), "0x%08x", cmdTableHash(cmds));
+
+  std::ostringstream o;
+  o << "#ifndef " << guard << "\n#define " << guard << "\n\n"
+    << "//generated by ardumon_gen from " << baseName(in_path) << " (" << cmds.size() << " commands), do not edit\n"
+    << "//see examples/demo/native/ardumon_gen.cpp\n\n"
+    << "#include <stdint.h>\n#include <string.h>\n\n"
+    << "namespace " << ns << " {\n\n"
+    << "//compare to ArduMon::getCmdHash() on the server\n"
+    << "constexpr uint32_t TABLE_HASH = " << hash << "UL;\n\n"
+    << "//must match the with_code16 template parameter of ArduMon on the server\n"
+    << "constexpr bool CODE16 = " << (code16 ? "true" : "false") << ";\n"
+    << PREAMBLE;
+  for (const CmdDesc &cmd : cmds) genCmd(o, cmd);
+  o << "\n} //namespace " << ns << "\n\n#endif //" << guard << "\n";
+
+  if (out_path.empty()) { std::cout << o.str(); return 0; }
+
+  std::ofstream out(out_path, std::ios::trunc);
+  if (!(out << o.str()) || (out.close(), !out)) { std::cerr << "ERROR: error writing " << out_path << "\n"; return 1; }
+  return 0;
+}
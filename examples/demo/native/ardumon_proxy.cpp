@@ -0,0 +1,561 @@
+/**
+ * ArduMon: Yet another Arduino serial command library.
+ *
+ * See https://github.com/martyvona/ArduMon/blob/main/README.md
+ *
+ * ardumon_proxy presents a text mode ArduMon CLI for a device that only speaks binary mode.  The device can then be
+ * built with with_text = false, which saves the flash and CPU of the text parser and formatter, and the link carries
+ * compact packets, while a human still gets a prompt, echo, line history, and command name completion.
+ *
+ * The CLI is served on a UNIX socket, or with --pty on a pseudo terminal, at cli_path, e.g. for minicom.  It is an
+ * ArduMon instance in text mode on the host, so it parses and formats values exactly as a text mode device would,
+ * including request tags.  Echo and prompt are suppressed while the input looks scripted rather than typed.
+ *
+ * Each command is looked up in a command description file, see cmd_desc.h.  Its arguments are parsed according to
+ * their described types and sent to the device as one binary packet by a second ArduMon instance in binary mode.  If
+ * the command has a described response then the next packet from the device is decoded according to the response
+ * types and sent back as text, otherwise the command completes immediately.  Binary responses do not carry their
+ * command code, so a packet that the device sends on its own while a response is expected is taken as the response.  A
+ * final ... in the arguments takes any number of further byte values, and in the response any further bytes are shown
+ * in hex.  Commands of a group can be invoked as one dotted token or as separate tokens, e.g. "fp.set 1.5" or
+ * "fp set 1.5".
+ *
+ * The help command is handled locally and lists the described commands.  Packets that the device sends while no
+ * response is expected, e.g. periodic telemetry or an error response to a command without a described response, are
+ * shown in hex.  Error responses, see ArduMon::setErrorResponse(), are recognized by the code given with --err_code,
+ * 0xEE by default as in the demo server, and shown as the error message.
+ *
+ * The device is a serial port file, or a UNIX socket if device_path starts with "unix#", e.g. the binary demo server:
+ *
+ * ./ardumon_server -b /tmp/dev &
+ * ./ardumon_proxy demo_cmds.txt unix#/tmp/dev /tmp/cli &
+ * minicom -D unix#/tmp/cli
+ *
+ * Usage: ardumon_proxy [-q|--quiet] [--pty] [--code16] [--speed=baud] [--recv_timeout=ms] [--err_code=code]
+ *                      [--end_marker[=marker]] desc_file [unix#]device_path cli_path
+ *
+ * --code16 must match the with_code16 template parameter of ArduMon on the device.  --end_marker enables the text end
+ * of response marker, by default the same one as the demo server, so that ardumon_client --end_marker can be used.
+ *
+ * Copyright 2025 Marsette A. Vona (martyvona@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <deque>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <poll.h>
+
+#include "arduino_shims.h"
+
+#include <ArduMon.h>
+
+#include "cmd_desc.h"
+#include "SerialPort.h" //for SerialPort<>::lowLatency()
+
+#define DEF_RECV_TIMEOUT_MS 1000
+#define DEF_BAUD 115200
+#define DEF_ERR_CODE 0xEE //ERR_RESPONSE_CODE in ../demo.h
+#define DEF_END_MARKER "\x1b]5379;end\x07" //TEXT_END_MARKER in ../demo.h
+#define RECV_GAP_US 5000 //resynchronize after a partial packet, e.g. boot noise from a device that was just reset
+#define PROMPT "ArduMon>"
+#define MAX_HISTORY 100
+#define SCRIPT_GAP_US 5000 //see detectScripted()
+#define SCRIPT_IDLE_MS 1000
+
+int dev_fileno = -1, cli_fileno = -1, listen_fileno = -1, pty_slave_fileno = -1;
+std::string cli_path;
+struct termios orig_attribs;
+bool read_orig_attribs = false, quiet = false;
+
+void cleanup() {
+  if (dev_fileno >= 0) {
+    if (read_orig_attribs) tcsetattr(dev_fileno, TCSANOW, &orig_attribs);
+    close(dev_fileno); dev_fileno = -1;
+  }
+  if (cli_fileno >= 0) { close(cli_fileno); cli_fileno = -1; }
+  if (listen_fileno >= 0) { close(listen_fileno); listen_fileno = -1; unlink(cli_path.c_str()); }
+  if (pty_slave_fileno >= 0) { close(pty_slave_fileno); pty_slave_fileno = -1; unlink(cli_path.c_str()); }
+}
+
+void usage() {
+  std::cerr << "USAGE: ardumon_proxy [-q|--quiet] [--pty] [--code16] [--speed=baud] [--recv_timeout=ms] "
+            << "[--err_code=code] [--end_marker[=marker]] desc_file [unix#]device_path cli_path\n";
+  exit(1);
+}
+
+bool is_arg(const char *arg, const char *name) {
+  const size_t n = strlen(name);
+  return strncmp(arg, name, n) == 0 && (arg[n] == 0 || arg[n] == '=');
+}
+
+const char *arg_val(const char *arg, const char *name) {
+  const size_t n = strlen(name);
+  if (arg[n] != '=' || !arg[n + 1]) usage();
+  return arg + n + 1;
+}
+
+//an unbounded ArduMonStream; the main loop moves its bytes from and to a file descriptor
+struct FifoStream : public ArduMonStream {
+  std::deque<uint8_t> in, out;
+  int16_t available() { return static_cast<int16_t>(std::min<size_t>(in.size(), INT16_MAX)); }
+  int16_t read() { if (in.empty()) return -1; const uint8_t c = in.front(); in.pop_front(); return c; }
+  int16_t peek() { return in.empty() ? -1 : in.front(); }
+  int16_t availableForWrite() { return INT16_MAX; }
+  uint16_t write(uint8_t c) { out.push_back(c); return 1; }
+};
+
+//read what is available from nonblocking fd into in; returns false on end of file or error other than EAGAIN
+bool fill(const int fd, std::deque<uint8_t> &in) {
+  uint8_t buf[1024];
+  const ssize_t nr = read(fd, buf, sizeof(buf));
+  if (nr < 0) return errno == EAGAIN || errno == EINTR;
+  in.insert(in.end(), buf, buf + nr);
+  return nr > 0;
+}
+
+//write what fd accepts from out without blocking; returns false on error other than EAGAIN
+bool drain(const int fd, std::deque<uint8_t> &out) {
+  while (!out.empty()) {
+    uint8_t buf[1024]; size_t n = 0;
+    for (auto it = out.begin(); it != out.end() && n < sizeof(buf); ++it) buf[n++] = *it;
+    const ssize_t nw = write(fd, buf, n);
+    if (nw < 0) return errno == EAGAIN || errno == EINTR;
+    out.erase(out.begin(), out.begin() + nw);
+    if (static_cast<size_t>(nw) < n) break;
+  }
+  return true;
+}
+
+using TextAM = ArduMon<1, 256, 16, true, true, true, false, true>;
+
+template <bool code16> class Proxy {
+public:
+
+  using BinAM = ArduMon<1, 256, 256, true, true, true, true, false, code16>;
+  using Type = CmdDesc::Type;
+
+  Proxy(const std::vector<CmdDesc> &_cmds, const unsigned long _recv_timeout_ms, const uint16_t _err_code,
+        const std::string &_end_marker)
+    : cmds(_cmds), recv_timeout_ms(_recv_timeout_ms), err_code(_err_code), end_marker(_end_marker),
+      text(&text_stream, false), bin(&bin_stream, true), text_cmd(*this), bin_resp(*this) {
+    text.setDefaultErrorHandler().setTextEcho(true).setUniversalRunnable(&text_cmd);
+    if (!end_marker.empty()) text.setTextEndMarker(end_marker.c_str());
+    text.setTextPrompt(PROMPT); //sends the first prompt
+    bin.setRecvGapUS(RECV_GAP_US).setUniversalRunnable(&bin_resp);
+    input_us = micros();
+    for (const CmdDesc &cmd : cmds) names.push_back(cmd.name);
+    names.push_back("help");
+    std::sort(names.begin(), names.end());
+  }
+
+  //move bytes between the device, the CLI, and the two ArduMon instances until either side hangs up
+  void run() {
+    for (;;) {
+      struct pollfd fds[2] = { { dev_fileno, POLLIN, 0 }, { cli_fileno, POLLIN, 0 } };
+      int timeout_ms = 100;
+      if (pending) timeout_ms = std::min<int>(timeout_ms, deadline > millis() ? deadline - millis() : 0);
+      if (poll(fds, 2, timeout_ms) < 0 && errno != EINTR) { perror("error polling"); return; }
+
+      if (!fill(dev_fileno, bin_stream.in)) { if (!quiet) std::cout << "device hung up\n"; return; }
+      std::deque<uint8_t> typed;
+      if (!fill(cli_fileno, typed)) { if (!quiet) std::cout << "CLI hung up\n"; return; }
+      if (!typed.empty()) detectScripted(typed);
+      for (const uint8_t c : typed) input(c);
+
+      bin.update();
+      while (text_stream.in.size() && !text.isHandling()) text.update(); //handle typed ahead commands in order
+
+      if (pending && millis() >= deadline) { //a late response is then shown as unexpected
+        pending = 0;
+        textError(static_cast<uint8_t>(TextAM::Error::RECV_TIMEOUT));
+      }
+
+      if (scripted && !pending && !text.isHandling() && micros() - input_us > SCRIPT_IDLE_MS * 1000) {
+        scripted = false;
+        text.setTextEcho(true).setTextPrompt(PROMPT);
+      }
+
+      if (!drain(dev_fileno, bin_stream.out)) { perror("error writing to device"); return; }
+      if (!drain(cli_fileno, text_stream.out)) { perror("error writing to CLI"); return; }
+    }
+  }
+
+private:
+
+  struct TextCmd : public TextAM::Runnable {
+    Proxy &p; TextCmd(Proxy &_p) : p(_p) {}
+    bool run(TextAM &) { return p.handleText(); }
+  };
+
+  struct BinResp : public BinAM::Runnable {
+    Proxy &p; BinResp(Proxy &_p) : p(_p) {}
+    bool run(BinAM &) { return p.handleBin(); }
+  };
+
+  //universal handler of the text CLI: translate the command to a packet and send it to the device
+  bool handleText() {
+    const char *tok;
+    if (!text.recv(tok)) return false;
+    std::string name = tok;
+    if (name == "help") return help();
+    const CmdDesc *cmd = find(name);
+    while (cmd && cmd->group && text.hasArg()) { //"group sub" is the same as "group.sub"
+      if (!text.recv(tok)) return false;
+      name += "."; name += tok;
+      cmd = find(name);
+    }
+    if (!cmd || cmd->group) return textError(static_cast<uint8_t>(TextAM::Error::BAD_CMD));
+
+    for (const uint16_t code : cmd->path) bin.sendCode(code);
+    const CmdDesc::Types &args = cmd->args;
+    for (size_t i = 0; i < args.types.size() && (i < args.num_required || text.hasArg()); i++) {
+      if (!xfer(text, bin, args.types[i])) return abandon();
+    }
+    while (args.more && text.hasArg()) if (!xfer(text, bin, Type::U08)) return abandon();
+    if (text.hasArg()) { bin.reset(); return textError(static_cast<uint8_t>(TextAM::Error::BAD_ARG)); }
+    if (!bin.sendPacket()) return abandon();
+
+    if (cmd->resp.types.empty() && !cmd->resp.more) return text.endHandler();
+    pending = cmd;
+    deadline = millis() + recv_timeout_ms;
+    return true; //the text command is ended when the response arrives, see handleBin()
+  }
+
+  //universal handler of the device link: receive the response to the pending command, or show an unexpected packet
+  bool handleBin() {
+
+    typename BinAM::Error e; typename BinAM::cmd_code_t code = 0;
+    if (err_code <= BinAM::MAX_CMD_CODE && bin.recvErrorResponse(err_code, e, code)) {
+      if (pending) { pending = 0; textError(static_cast<uint8_t>(e)); }
+      else show(std::string("device error: ") + BinAM::errMsg(e) + " (command " + std::to_string(code) + ")");
+      return bin.endHandler();
+    }
+
+    if (!pending) {
+      if (bin.recvReady()) show("device ready"); //e.g. the device was reset
+      else {
+        std::string hex;
+        while (bin.hasArg()) { uint8_t b = 0; bin.recv(b); hex += (hex.empty() ? "" : " ") + toHex(b); }
+        show("device sent: " + hex);
+      }
+      return bin.endHandler();
+    }
+
+    const CmdDesc::Types &resp = pending->resp;
+    pending = 0;
+    for (size_t i = 0; i < resp.types.size() && (i < resp.num_required || bin.hasArg()); i++) {
+      if (!xfer(bin, text, resp.types[i])) break;
+    }
+    while (!bin.hasErr() && bin.hasArg()) { uint8_t b = 0; bin.recv(b); text.send(b, TextAM::FMT_HEX); }
+    if (bin.hasErr()) textError(static_cast<uint8_t>(bin.clearErr())); //e.g. the response was too short
+    else text.endHandler();
+    return bin.endHandler();
+  }
+
+  //receive a value of type t from one ArduMon and send it with the other
+  template <typename From, typename To> static bool xfer(From &from, To &to, const Type t) {
+    switch (t) {
+      case Type::CHR: { char v; return from.recvChar(v) && to.sendChar(v); }
+      case Type::STR: { const char *v; return from.recv(v) && to.send(v); }
+      case Type::BLL: { bool v; return from.recv(v) && to.send(v); }
+      case Type::U08: { uint8_t v; return from.recv(v) && to.send(v); }
+      case Type::I08: { int8_t v; return from.recv(v) && to.send(v); }
+      case Type::U16: { uint16_t v; return from.recv(v) && to.send(v); }
+      case Type::I16: { int16_t v; return from.recv(v) && to.send(v); }
+      case Type::U32: { uint32_t v; return from.recv(v) && to.send(v); }
+      case Type::I32: { int32_t v; return from.recv(v) && to.send(v); }
+      case Type::U64: { uint64_t v; return from.recv(v) && to.send(v); }
+      case Type::I64: { int64_t v; return from.recv(v) && to.send(v); }
+      case Type::F32: { float v; return from.recv(v) && to.send(v); }
+      case Type::F64: { double v; return from.recv(v) && to.send(v); }
+      default: return false;
+    }
+  }
+
+  //discard the partial packet after a failed xfer() to the device
+  //a text parse error is reported by the default error handler of the CLI, a device link error is reported here
+  bool abandon() {
+    const uint8_t e = static_cast<uint8_t>(bin.clearErr());
+    bin.reset();
+    return text.hasErr() ? false : textError(e);
+  }
+
+  //end the current text command with the message of error e, as the default error handler of a text device would
+  bool textError(const uint8_t e) {
+    return text.sendCRLF().sendRaw(TextAM::errMsg(static_cast<typename TextAM::Error>(e))).sendCRLF(true).endHandler();
+  }
+
+  bool help() {
+    for (const CmdDesc &cmd : cmds) {
+      text.sendRaw(cmd.name.c_str());
+      const auto types = [&](const CmdDesc::Types &ts) {
+        for (size_t i = 0; i < ts.types.size(); i++) {
+          text.sendRaw(" ").sendRaw(CmdDesc::info(ts.types[i]).name);
+          if (i >= ts.num_required) text.sendRaw("?");
+        }
+        if (ts.more) text.sendRaw(" ...");
+      };
+      types(cmd.args);
+      if (!cmd.resp.types.empty() || cmd.resp.more) { text.sendRaw(" :"); types(cmd.resp); }
+      if (!cmd.description.empty()) text.sendRaw(" | ").sendRaw(cmd.description.c_str());
+      text.sendCRLF(true);
+    }
+    return text.sendRaw("help | show commands, handled by ardumon_proxy").sendCRLF(true).endHandler();
+  }
+
+  const CmdDesc *find(const std::string &name) {
+    for (const CmdDesc &cmd : cmds) if (cmd.name == name) return &cmd;
+    return 0;
+  }
+
+  static std::string toHex(const uint8_t b) {
+    static const char *digits = "0123456789ABCDEF";
+    return std::string(1, digits[b >> 4]) + digits[b&0xf];
+  }
+
+  //show a line on the CLI between commands, then restore the prompt and whatever was typed of the next command
+  void show(const std::string &msg) {
+    write("\r\n" + msg + "\r\n");
+    if (!scripted) write(std::string(PROMPT) + " " + line);
+  }
+
+  void write(const std::string &s) { text_stream.out.insert(text_stream.out.end(), s.begin(), s.end()); }
+
+  void type(const char c) { text_stream.in.push_back(static_cast<uint8_t>(c)); }
+
+  //suppress echo and prompt while the input looks scripted, like ArduMon::setTextAutoQuiet() but judged on the input
+  //as it arrives, since the characters that input() adds for completion and history would look scripted to the CLI
+  //more than one character at once, other than line endings or one escape sequence, or a character too soon after
+  //the previous input, looks scripted; run() restores echo and prompt after the input is idle for SCRIPT_IDLE_MS
+  void detectScripted(const std::deque<uint8_t> &typed) {
+    const uint64_t now = micros();
+    const size_t n = std::count_if(typed.begin(), typed.end(), [](uint8_t c) { return c != '\r' && c != '\n'; });
+    const bool esc = typed[0] == 27 && typed.size() <= 3;
+    if (!scripted && !esc && n > 0 && (n > 1 || now - input_us < SCRIPT_GAP_US)) {
+      scripted = true;
+      text.setTextEcho(false).setTextPrompt(static_cast<const char*>(0));
+    }
+    input_us = now;
+  }
+
+  //pass a typed character on to the CLI, except up and down arrows, which recall the history, and tab, which
+  //completes the command name; line tracks what the CLI has received of the current command
+  void input(const uint8_t c) {
+    if (esc == 1) { esc = c == '[' ? 2 : 0; return; }
+    if (esc == 2) { //the last character of an escape sequence, ignore all but the up and down arrows
+      esc = 0;
+      if (c == 'A' && hist_idx > 0) recall(history[--hist_idx]);
+      else if (c == 'B' && hist_idx < history.size()) recall(++hist_idx < history.size() ? history[hist_idx] : "");
+      return;
+    }
+    switch (c) {
+      case 27: esc = 1; return;
+      case '\t': complete(); return;
+      case '\r': case '\n':
+        if (!line.empty() && (history.empty() || history.back() != line)) history.push_back(line);
+        if (history.size() > MAX_HISTORY) history.erase(history.begin());
+        hist_idx = history.size();
+        line.clear();
+        break;
+      case '\b': case 0x7f: if (!line.empty()) line.pop_back(); break;
+      default: line += static_cast<char>(c);
+    }
+    type(c);
+  }
+
+  //replace the current command with s by typing backspaces and then s
+  void recall(const std::string &s) {
+    for (size_t i = 0; i < line.length(); i++) type('\b');
+    for (const char c : s) type(c);
+    line = s;
+  }
+
+  //complete the command name being typed, or extend it as far as it is unique and show the candidates
+  void complete() {
+    if (line.find_first_of(" \t") != std::string::npos) return; //only the first token is completed
+    std::vector<std::string> cands;
+    for (const std::string &n : names) if (n.compare(0, line.length(), line) == 0) cands.push_back(n);
+    if (cands.empty()) return;
+    std::string ext = cands[0].substr(line.length());
+    for (const std::string &n : cands) {
+      size_t i = 0;
+      while (i < ext.length() && line.length() + i < n.length() && n[line.length() + i] == ext[i]) ++i;
+      ext.resize(i);
+    }
+    if (cands.size() == 1) ext += ' ';
+    for (const char c : ext) { type(c); line += c; }
+    if (cands.size() == 1 || !ext.empty()) return;
+    while (text_stream.in.size() && !text.isHandling()) text.update(); //echo what was typed before the list
+    std::string list;
+    for (const std::string &n : cands) list += (list.empty() ? "" : "  ") + n;
+    show(list);
+  }
+
+  const std::vector<CmdDesc> &cmds;
+  const unsigned long recv_timeout_ms;
+  const uint16_t err_code;
+  const std::string end_marker;
+
+  FifoStream text_stream, bin_stream;
+  TextAM text;
+  BinAM bin;
+  TextCmd text_cmd;
+  BinResp bin_resp;
+
+  const CmdDesc *pending = 0; //the command whose response is expected, if any
+  uint64_t deadline = 0; //for the response to the pending command
+
+  std::vector<std::string> names; //of all commands, for completion
+  std::string line; //the current command as typed so far
+  std::vector<std::string> history;
+  size_t hist_idx = 0;
+  uint8_t esc = 0; //1 after an escape character, 2 after an escape character and '['
+  bool scripted = false; //see detectScripted()
+  uint64_t input_us = 0; //micros() when input was last received
+};
+
+int main(int argc, const char **argv) {
+
+  atexit(cleanup);
+
+  struct sigaction sig_handler;
+  sig_handler.sa_handler = [](int) { exit(1); }; //runs cleanup(), which removes cli_path
+  sigemptyset(&sig_handler.sa_mask);
+  sig_handler.sa_flags = 0;
+  sigaction(SIGINT, &sig_handler, NULL);
+  sigaction(SIGTERM, &sig_handler, NULL);
+  signal(SIGPIPE, SIG_IGN); //a CLI or device that hangs up is detected by write()
+
+  bool pty = false, code16 = false;
+  speed_t speed = DEF_BAUD;
+  unsigned long recv_timeout_ms = DEF_RECV_TIMEOUT_MS;
+  uint16_t err_code = DEF_ERR_CODE;
+  std::string end_marker;
+  std::vector<const char*> pos;
+
+  for (int i = 1; i < argc; i++) {
+    if (argv[i][0] != '-') pos.push_back(argv[i]);
+    else if (strcmp(argv[i], "-q") == 0 || strcmp(argv[i], "--quiet") == 0) quiet = true;
+    else if (strcmp(argv[i], "--pty") == 0) pty = true;
+    else if (strcmp(argv[i], "--code16") == 0) code16 = true;
+    else if (is_arg(argv[i], "--speed")) speed = strtoul(arg_val(argv[i], "--speed"), 0, 0);
+    else if (is_arg(argv[i], "--recv_timeout")) recv_timeout_ms = strtoul(arg_val(argv[i], "--recv_timeout"), 0, 0);
+    else if (is_arg(argv[i], "--err_code")) err_code = strtoul(arg_val(argv[i], "--err_code"), 0, 0);
+    else if (is_arg(argv[i], "--end_marker")) {
+      end_marker = argv[i][strlen("--end_marker")] ? arg_val(argv[i], "--end_marker") : DEF_END_MARKER;
+    }
+    else usage();
+  }
+  if (pos.size() != 3) usage();
+
+  std::ifstream desc_in(pos[0]);
+  if (!desc_in) { perror((std::string("error opening ") + pos[0]).c_str()); exit(1); }
+  std::vector<CmdDesc> cmds;
+  const std::string msg = parseCmdDescs(desc_in, cmds);
+  if (!msg.empty()) { std::cerr << pos[0] << " " << msg << "\n"; exit(1); }
+
+  std::string dev_path = pos[1];
+  cli_path = pos[2];
+
+  const bool dev_socket = dev_path.compare(0, 5, "unix#") == 0;
+  if (dev_socket) { //the device is a UNIX socket, e.g. ardumon_server -b
+
+    dev_path.erase(0, 5);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, dev_path.c_str(), sizeof(addr.sun_path) - 1);
+    dev_fileno = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (dev_fileno < 0 || connect(dev_fileno, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+      perror(("error connecting to " + dev_path).c_str()); exit(1);
+    }
+
+  } else { //the device is a serial port file
+
+    dev_fileno = open(dev_path.c_str(), O_RDWR | O_NOCTTY);
+    if (dev_fileno < 0) { perror(("error opening " + dev_path).c_str()); exit(1); }
+    struct termios t;
+    if (tcgetattr(dev_fileno, &t) != 0) { perror(("error getting attribs on " + dev_path).c_str()); exit(1); }
+    memcpy(&orig_attribs, &t, sizeof(t)); read_orig_attribs = true;
+    cfmakeraw(&t);
+    t.c_cc[VMIN] = 1; t.c_cc[VTIME] = 0;
+    if (cfsetspeed(&t, speed) != 0) { perror(("error setting speed on " + dev_path).c_str()); exit(1); }
+    t.c_cflag &= ~HUPCL; orig_attribs.c_cflag &= ~HUPCL; //see the native client in demo.cpp
+    if (tcsetattr(dev_fileno, TCSANOW, &t) != 0) { perror(("error setting attribs on " + dev_path).c_str()); exit(1); }
+    SerialPort<>::lowLatency(dev_fileno);
+  }
+
+  struct stat st;
+  if (lstat(cli_path.c_str(), &st) == 0 && (S_ISLNK(st.st_mode) || S_ISSOCK(st.st_mode))) unlink(cli_path.c_str());
+
+  if (pty) { //serve the CLI on a pseudo terminal linked at cli_path
+
+    cli_fileno = posix_openpt(O_RDWR | O_NOCTTY);
+    if (cli_fileno < 0 || grantpt(cli_fileno) != 0 || unlockpt(cli_fileno) != 0) {
+      perror("error creating pseudo terminal"); exit(1);
+    }
+    const std::string slave_path = ptsname(cli_fileno);
+    pty_slave_fileno = open(slave_path.c_str(), O_RDWR | O_NOCTTY); //so reads do not fail while no terminal has it
+    struct termios t;
+    if (pty_slave_fileno < 0 || tcgetattr(pty_slave_fileno, &t) != 0) {
+      perror(("error opening " + slave_path).c_str()); exit(1);
+    }
+    cfmakeraw(&t);
+    tcsetattr(pty_slave_fileno, TCSANOW, &t);
+    if (symlink(slave_path.c_str(), cli_path.c_str()) != 0) { perror(("error linking " + cli_path).c_str()); exit(1); }
+    if (!quiet) std::cout << "ardumon_proxy: " << cli_path << " -> " << slave_path << "\n" << std::flush;
+
+  } else { //serve the CLI on a UNIX socket at cli_path
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, cli_path.c_str(), sizeof(addr.sun_path) - 1);
+    listen_fileno = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fileno < 0 || bind(listen_fileno, (const struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(listen_fileno, 1) != 0) {
+      perror(("error listening on " + cli_path).c_str()); exit(1);
+    }
+    if (!quiet) std::cout << "ardumon_proxy: waiting for connection on " << cli_path << "...\n" << std::flush;
+    cli_fileno = accept(listen_fileno, NULL, NULL);
+    if (cli_fileno < 0) { perror(("error accepting connection on " + cli_path).c_str()); exit(1); }
+  }
+
+  fcntl(dev_fileno, F_SETFL, O_NONBLOCK);
+  fcntl(cli_fileno, F_SETFL, O_NONBLOCK);
+
+  if (!quiet) std::cout << "proxying " << cmds.size() << " commands from " << pos[0] << "\n" << std::flush;
+
+  if (code16) Proxy<true>(cmds, recv_timeout_ms, err_code, end_marker).run();
+  else Proxy<false>(cmds, recv_timeout_ms, err_code, end_marker).run();
+
+  return 0;
+}
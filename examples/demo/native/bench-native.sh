@@ -0,0 +1,15 @@
+#!/bin/bash
+
+# build and run ardumon_bench once for each kernel variant of ArduMon.h, see ardumon_bench.cpp
+# any argument is passed on as the number of runs of each benchmark
+
+script_dir=$( cd -- "$( dirname -- "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )
+
+OPTS="--std=c++11 -O3 -I${script_dir}/../../../src"
+
+for variant in "" "-U__SSE2__ -U__ARM_NEON" "-DARDUMON_NO_SIMD"; do
+  g++ $OPTS $variant -o ardumon_bench ardumon_bench.cpp || exit $?
+  ./ardumon_bench "$@" || exit $?
+done
+
+rm -f ardumon_bench
@@ -2,7 +2,7 @@
 
 echo "buidlng for native"
 
-OPTS=--std=c++11
+OPTS="--std=c++11 -pthread"
 
 # -Wstringop-overflow=0 suppresses a spurious warning on some versions of g++ with -O3 
 # https://stackoverflow.com/a/75191691
@@ -19,9 +19,25 @@ else
 OPTS="$OPTS -O3"
 fi
 
+echo "building native ardumon_gen${DBG}..."
+g++ $OPTS -o ardumon_gen ardumon_gen.cpp || exit $?
+
+# ../demo_cmds.h is checked in since the Arduino sketch also uses it; fail if it is out of date instead of rewriting it
+echo "checking ../demo_cmds.h against demo_cmds.txt..."
+gen_tmp=$(mktemp) || exit $?
+./ardumon_gen demo_cmds.txt $gen_tmp || { rm -f $gen_tmp; exit 1; }
+if ! cmp -s $gen_tmp ../demo_cmds.h; then
+  rm -f $gen_tmp
+  echo "../demo_cmds.h is out of date, regenerate it with ./ardumon_gen demo_cmds.txt ../demo_cmds.h"
+  exit 1
+fi
+rm -f $gen_tmp
+
 echo "building native ardumon_server${DBG}..."
 g++ $OPTS -I${script_dir}/../../../src -o ardumon_server demo.cpp || exit $?
 
 echo "building native ardumon_client${DBG}..."
 g++ $OPTS -I${script_dir}/../../../src -o ardumon_client -DDEMO_CLIENT demo.cpp || exit $?
 
+echo "building native ardumon_proxy${DBG}..."
+g++ $OPTS -I${script_dir}/../../../src -o ardumon_proxy ardumon_proxy.cpp || exit $?
@@ -0,0 +1,182 @@
+#ifndef AM_CMD_DESC_H
+#define AM_CMD_DESC_H
+
+/**
+ * ArduMon: Yet another Arduino serial command library.
+ *
+ * See https://github.com/martyvona/ArduMon/blob/main/README.md
+ *
+ * This parses a command description file, which lists the name, binary code, and argument and response types of each
+ * command of an ArduMon server.  Each non-empty line that does not start with # describes one command:
+ *
+ * code name [arg_type...] [: response_type...] [| description]
+ *
+ * * code is the binary command code; the code of a subcommand is dotted, e.g. 23.1 for subcommand 1 of group 23
+ * * name is the command name; the name of a subcommand is dotted, e.g. fp.get, and its group must also be listed
+ * * the types are the same as those of the demo em command: chr, str, bll, u08, i08, u16, i16, u32, i32, u64, i64,
+ *   f32, f64; a type followed by ? is optional, and only optional types may follow it
+ * * a final ... in the arguments or the response means that more bytes may follow which are not described
+ * * the description is free text, as in ArduMon::addCmd()
+ *
+ * All commands of the server must be listed, including commands without arguments or responses, so that the hash
+ * returned by cmdTableHash() matches ArduMon::getCmdHash() on the server.  The types are not part of the hash.
+ *
+ * This file is designed to be included in the native tools, e.g. ardumon_gen.cpp.
+ *
+ * Copyright 2025 Marsette A. Vona (martyvona@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <istream>
+#include <sstream>
+
+struct CmdDesc {
+
+  enum class Type : uint8_t { CHR, STR, BLL, U08, I08, U16, I16, U32, I32, U64, I64, F32, F64, NUM_TYPES };
+
+  //the name in description files, the size in binary packets (0 for null terminated strings), and the C++ type
+  struct TypeInfo { const char *name; uint8_t size; const char *c_type; };
+
+  static const TypeInfo& info(const Type t) {
+    static const TypeInfo infos[] = {
+      { "chr", 1, "char" }, { "str", 0, "const char*" }, { "bll", 1, "bool" },
+      { "u08", 1, "uint8_t" }, { "i08", 1, "int8_t" }, { "u16", 2, "uint16_t" }, { "i16", 2, "int16_t" },
+      { "u32", 4, "uint32_t" }, { "i32", 4, "int32_t" }, { "u64", 8, "uint64_t" }, { "i64", 8, "int64_t" },
+      { "f32", 4, "float" }, { "f64", 8, "double" }
+    };
+    return infos[static_cast<uint8_t>(t)];
+  }
+
+  //the argument or response types of a command
+  struct Types {
+    std::vector<Type> types;
+    size_t num_required = 0; //the rest are optional
+    bool more = false; //true if undescribed bytes may follow
+  };
+
+  std::string name; //dotted for subcommands
+  std::vector<uint16_t> path; //the codes of the enclosing groups, if any, then the code of this command
+  Types args, resp;
+  std::string description;
+  bool group = false; //true if other commands are listed as its subcommands
+
+  uint16_t code() const { return path.back(); }
+
+  //the 32 bit FNV-1a hash of the name, a 0 byte, and the codes on the path, each as two bytes little endian
+  uint32_t hash() const {
+    uint32_t h = 2166136261UL;
+    const auto add = [&](const uint8_t b) { h = (h ^ b) * 16777619UL; };
+    for (const char c : name) add(static_cast<uint8_t>(c));
+    add(0);
+    for (const uint16_t c : path) { add(static_cast<uint8_t>(c)); add(static_cast<uint8_t>(c >> 8)); }
+    return h;
+  }
+};
+
+//the sum of the hashes of all commands, which matches ArduMon::getCmdHash() on a server with the same commands
+inline uint32_t cmdTableHash(const std::vector<CmdDesc> &cmds) {
+  uint32_t sum = 0;
+  for (const CmdDesc &cmd : cmds) sum += cmd.hash();
+  return sum;
+}
+
+//parse a command description file from in and append its commands to cmds, in the order listed
+//returns an empty string on success, otherwise an error message including the line number
+inline std::string parseCmdDescs(std::istream &in, std::vector<CmdDesc> &cmds) {
+
+  const auto parseTypes = [](std::istringstream &toks, CmdDesc::Types &types, const bool args) -> std::string {
+    std::string tok;
+    while (toks >> tok) {
+      if (args && tok == ":") break;
+      if (types.more) return "types after ...";
+      if (tok == "...") { types.more = true; continue; }
+      const bool optional = tok.back() == '?';
+      if (optional) tok.pop_back();
+      uint8_t t = 0;
+      while (t < static_cast<uint8_t>(CmdDesc::Type::NUM_TYPES) &&
+             tok != CmdDesc::info(static_cast<CmdDesc::Type>(t)).name) ++t;
+      if (t == static_cast<uint8_t>(CmdDesc::Type::NUM_TYPES)) return "unknown type " + tok;
+      if (!optional && types.num_required < types.types.size()) return "required type " + tok + " after optional";
+      types.types.push_back(static_cast<CmdDesc::Type>(t));
+      if (!optional) types.num_required = types.types.size();
+    }
+    return "";
+  };
+
+  const size_t first = cmds.size();
+  std::string ln;
+  for (int line = 1; std::getline(in, ln); line++) {
+
+    const auto err = [&](const std::string &msg) { return "line " + std::to_string(line) + ": " + msg; };
+
+    const size_t start = ln.find_first_not_of(" \t\r");
+    if (start == std::string::npos || ln[start] == '#') continue; //ignore empty line or comment
+
+    CmdDesc cmd;
+    const size_t bar = ln.find('|');
+    if (bar != std::string::npos) {
+      const size_t d = ln.find_first_not_of(" \t", bar + 1), e = ln.find_last_not_of(" \t\r");
+      if (d != std::string::npos && d <= e) cmd.description = ln.substr(d, e - d + 1);
+      ln.resize(bar);
+    }
+
+    std::istringstream toks(ln);
+    std::string code;
+    if (!(toks >> code >> cmd.name)) return err("expected code and name");
+
+    for (size_t i = 0; i <= code.length(); ) { //dotted code
+      char *end;
+      const unsigned long c = strtoul(code.c_str() + i, &end, 0);
+      const size_t j = end - code.c_str();
+      if (j == i || (j < code.length() && code[j] != '.') || c > 0x7fff) return err("bad code " + code);
+      cmd.path.push_back(static_cast<uint16_t>(c));
+      i = j + 1;
+    }
+
+    if (static_cast<size_t>(std::count(cmd.name.begin(), cmd.name.end(), '.')) + 1 != cmd.path.size()) {
+      return err("name " + cmd.name + " does not match code " + code);
+    }
+
+    std::string msg = parseTypes(toks, cmd.args, true);
+    if (msg.empty()) msg = parseTypes(toks, cmd.resp, false);
+    if (!msg.empty()) return err(msg);
+
+    for (size_t i = first; i < cmds.size(); i++) {
+      if (cmds[i].name == cmd.name) return err("duplicate name " + cmd.name);
+      if (cmds[i].path == cmd.path) return err("duplicate code " + code);
+    }
+
+    if (cmd.path.size() > 1) { //find the group
+      const std::string group_name = cmd.name.substr(0, cmd.name.rfind('.'));
+      const std::vector<uint16_t> group_path(cmd.path.begin(), cmd.path.end() - 1);
+      size_t i = first;
+      while (i < cmds.size() && cmds[i].name != group_name) i++;
+      if (i == cmds.size()) return err("group " + group_name + " must be listed before " + cmd.name);
+      if (cmds[i].path != group_path) return err("code " + code + " does not match group " + group_name);
+      cmds[i].group = true;
+    }
+
+    cmds.push_back(cmd);
+  }
+
+  return "";
+}
+
+#endif //AM_CMD_DESC_H
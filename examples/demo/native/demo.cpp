@@ -10,16 +10,25 @@
  * * with DEMO_CLIENT not defined, resulting in executable server file "ardumon_server"
  * * with DEMO_CLIENT defined, resulting in executable file "ardumon_client"
  *
- * ardumon_server always creates a UNIX socket file; it runs in text mode by default.  Connect to it either with a
+ * ardumon_server creates a UNIX socket file by default; it runs in text mode by default.  Connect to it either with a
  * serial terminal like minicom that can handle UNIX sockets, or with ardumon_client to run a prepared set of text
  * commands.  Adding the --binary command line option to ardumon_server switches it to binary mode.  Run ardumon_client
  * --binary_demo to connect to it and run a hardcoded set of demo commands.
  *
+ * With --pty ardumon_server instead creates a pseudo terminal and links it at the given path, so that ardumon_client
+ * connects to it as to a serial port, see SerialPort.h.
+ *
+ * With --persist=path ardumon_server persists its float param in the given file, like an Arduino would in its EEPROM,
+ * see ArduMonPersist.h and FileStorage.h.
+ *
  * ardumon_client can also connect to a serial port file corresponding to an actual Arduino.  If the Arduino implements
  * any ArduMon text mode CLI it can be exercised with an ArduMon script, see ardumon_script.txt for the syntax and an
  * example.  If the Arduino is running the ArduMon binary demo server then it can be exercised with the --binary_demo
  * option.
  *
+ * ardumon_client --metrics instead connects to a binary server and periodically writes its performance counters in the
+ * Prometheus text format to stdout, or to the file given by --metrics_file, see metrics.h.
+ *
  * Copyright 2025 Marsette A. Vona (martyvona@gmail.com)
  *
  * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
@@ -60,6 +69,7 @@
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <signal.h>
+#include <poll.h>
 
 #include "arduino_shims.h"
 #include "CircBuf.h"
@@ -74,7 +84,10 @@ public :
 
   BufStream() : in("serial receive"), out("serial send") {}
 
-  int16_t available() { return in.size(); }
+  //optional hook to refill in, so that command handlers that block waiting for input can make progress
+  void (*refill)() = 0;
+
+  int16_t available() { if (refill && in.size() == 0) refill(); return in.size(); }
   int16_t read() { return in.get(); }
   int16_t peek() { return in.size() > 0 ? static_cast<int16_t>(in.peek()) : -1; }
 
@@ -99,28 +112,53 @@ BufStream<SERIAL_IN_BUF_SZ, SERIAL_OUT_BUF_SZ> demo_stream;
 #define AM_STREAM demo_stream
 #include "../demo.h"
 
+#ifdef DEMO_CLIENT
+#include "metrics.h"
+#include "SerialPort.h"
+#else
+#include "FileStorage.h"
+#endif
+
 #define DEF_WAIT_MS 100
 #define DEF_RECV_TIMEOUT_MS 5000
 #define DEF_BAUD 115200
+#define DEF_READY_TIMEOUT_MS 5000
+#define READY_PROBE_INTERVAL_MS 100
+#define READY_QUIET_MS 50
+#define DEF_METRICS_PERIOD_MS 1000
 
 #ifdef DEMO_CLIENT
 struct termios orig_attribs;
 bool read_orig_attribs = false;
+SerialPort<> serial; //only started if com_path is a serial port file, see SerialPort.h
 #else
 int listen_fileno = -1;
+int pty_slave_fileno = -1; //held open by the server with --pty so that reads do not fail while no client has it open
+FileStorage<> persist_file; //only opened with --persist, see ArduMonPersist.h
 #endif
 int com_fileno = -1;
 std::string com_path;
 bool quiet = false;
 
+#ifndef DEMO_CLIENT
+//move any bytes waiting in com_fileno to demo_stream.in without blocking
+//the main loop also does this, but a streaming command handler blocks in it waiting for input, see setStreaming()
+void refillDemoStream() {
+  uint8_t buf[SERIAL_IN_BUF_SZ];
+  const int nr = read(com_fileno, buf, demo_stream.in.free());
+  for (int i = 0; i < nr; i++) demo_stream.in.put(buf[i]);
+}
+#endif
+
 void usage() {
 #ifdef DEMO_CLIENT
   std::string role = "_client";
-  std::string args = "[--binary_demo] [--auto_wait[=ms]] [--recv_timeout[=ms]] [--speed=baud] [unix#]";
+  std::string args = "[--binary_demo|--metrics[=period_ms] [--metrics_file=path]] [--auto_wait[=ms]] "
+    "[--end_marker[=marker]] [--recv_timeout[=ms]] [--ready_timeout=ms] [--speed=baud] [unix#]";
   std::string sfx = " [< ardumon_script.txt]";
 #else
   std::string role = "_server";
-  std::string args = "[-b|--binary] ";
+  std::string args = "[-b|--binary] [--pty] [--persist=path] ";
   std::string sfx = "";
 #endif
   std::cerr << "USAGE: ardumon" << role
@@ -148,12 +186,46 @@ bool is_empty(const std::string path) { struct stat s; return (stat(path.c_str()
 
 void sleep_ms(const uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
 
+#ifdef DEMO_CLIENT
+//wait until the device on nonblocking com_fileno responds to probe, which is re-sent periodically, or announces that
+//it's ready (see ArduMon::sendReady()), or until timeout_ms elapses
+//then discard received bytes until the line has been quiet for READY_QUIET_MS; returns false on timeout
+//if the device was not reset when the port was opened this takes about READY_QUIET_MS plus one round trip
+bool wait_ready(const std::string &probe, const uint32_t timeout_ms) {
+  char b[256]; bool ready = false;
+  const uint64_t deadline = millis() + timeout_ms;
+  for (uint64_t next_probe = 0; !ready && millis() < deadline; sleep_ms(1)) {
+    if (millis() >= next_probe) {
+      //probe bytes sent while the Arduino bootloader is running are lost, so a partial probe may be received
+      if (write(com_fileno, probe.data(), probe.length()) < 0 && errno != EAGAIN) return false;
+      next_probe = millis() + READY_PROBE_INTERVAL_MS;
+    }
+    ready = read(com_fileno, b, sizeof(b)) > 0;
+  }
+  for (uint64_t quiet_until = millis() + READY_QUIET_MS; millis() < quiet_until; sleep_ms(1)) {
+    if (read(com_fileno, b, sizeof(b)) > 0) quiet_until = millis() + READY_QUIET_MS;
+  }
+  return ready;
+}
+
+//binary probe: packet invoking the demo server ready command, any response will do
+std::string binary_ready_probe() {
+  char buf[8]; return std::string(buf, demo_cmds::encodeReady(buf, sizeof(buf)));
+}
+
+//text probe: the ready command, which is answered also with echo and prompt off, e.g. after the quiet command
+const char *TEXT_READY_PROBE = "ready\r";
+#endif
+
 void cleanup() {
   if (com_fileno >= 0) {
 #ifdef DEMO_CLIENT
+    serial.stop();
     if (read_orig_attribs) {
       if (!quiet) std::cout << "restoring attributes on " << com_path << "\n";
-      if (tcsetattr(com_fileno, TCSANOW, &orig_attribs) != 0) perror(("error setting attribs on " + com_path).c_str());
+      if (tcsetattr(com_fileno, TCSANOW, &orig_attribs) != 0 && errno != EIO) { //EIO if the port already hung up
+        perror(("error setting attribs on " + com_path).c_str());
+      }
     }
 #endif
     if (!quiet) std::cout << "closing " << com_path << "\n";
@@ -162,6 +234,7 @@ void cleanup() {
   }
 #ifndef DEMO_CLIENT
   if (listen_fileno >= 0) { close(listen_fileno); listen_fileno = -1; }
+  if (pty_slave_fileno >= 0) { close(pty_slave_fileno); pty_slave_fileno = -1; unlink(com_path.c_str()); }
   if (exists(com_path) && is_empty(com_path)) unlink(com_path.c_str());
 #endif
 }
@@ -179,6 +252,9 @@ void terminate_handler(int s) { terminated(); }
 
 using Script = std::vector<std::pair<std::string, std::string>>;
 
+//true if a script command line starts with a request tag, e.g. "@17 gfp", see ArduMon::getTextTag()
+bool is_tagged(const std::string &ln) { return ln.length() > 1 && ln[0] == '@' && isdigit(ln[1]); }
+
 Script read_script(const uint32_t def_wait_ms, const bool auto_wait) {
   Script ret; std::string ln, def_wait = std::to_string(def_wait_ms);
   while (std::getline(std::cin, ln)) {
@@ -189,12 +265,14 @@ Script read_script(const uint32_t def_wait_ms, const bool auto_wait) {
     else if (ln[0] == '@') ret.emplace_back("recv", "@\n"); //recv "@\n" means receive line and echo it
     else if (ln[0] == '?') ret.emplace_back("wait", ln.length() > 1 ? ln.substr(1) : def_wait);
     else {
-      if (auto_wait && !ret.empty() && ret.back().first == "send") ret.emplace_back("wait", def_wait);
       //if command line starts with a space, remove it
       //this allows e.g. " >foo" to issue command ">foo" that starts with >, i.e. the leading space escapes the >
       //by just stripping a single space we also allow commands that start with whitespace, e.g. "  foo" -> " foo"
       //the ArduMon command interpreter should in turn ignore leading whitespace, but the point may be to test that
       if (ln[0] == ' ') ln.erase(0, 1);
+      //consecutive tagged commands are pipelined, so their responses are expected after the last one
+      const bool pipelined = !ret.empty() && is_tagged(ret.back().second) && is_tagged(ln);
+      if (auto_wait && !ret.empty() && ret.back().first == "send" && !pipelined) ret.emplace_back("wait", def_wait);
       ret.emplace_back("send", ln);
     }
   }
@@ -236,7 +314,15 @@ int main(int argc, const char **argv) {
   const char *com_file_or_path = 0;
   bool verbose = false, binary = false, auto_wait = false;
   uint32_t def_wait_ms = DEF_WAIT_MS, recv_timeout = 0;
-  speed_t speed;
+  std::string metrics_file, end_marker = TEXT_END_MARKER, persist_path;
+  bool use_end_marker = false;
+  speed_t speed = DEF_BAUD;
+#ifdef DEMO_CLIENT
+  uint32_t metrics_period_ms = 0, ready_timeout = DEF_READY_TIMEOUT_MS;
+  bool probe_ready = false;
+#else
+  bool pty = false;
+#endif
   Script script;
 
   for (int i = 1; i < argc; i++) {
@@ -245,17 +331,32 @@ int main(int argc, const char **argv) {
       else if (strcmp(argv[i], "-q") == 0 || strcmp(argv[i], "--quiet") == 0) quiet = true;
 #ifdef DEMO_CLIENT
       else if (strcmp(argv[i], "--binary_demo") == 0) binary = true;
+      else if (is_int_arg(argv[i], "--end_marker")) {
+        use_end_marker = true;
+        if (is_full_int_arg(argv[i], "--end_marker")) end_marker = argv[i] + strlen("--end_marker") + 1;
+      }
+      else if (is_int_arg(argv[i], "--metrics_file")) {
+        if (!is_full_int_arg(argv[i], "--metrics_file")) usage();
+        metrics_file = argv[i] + strlen("--metrics_file") + 1;
+      } else if (is_int_arg(argv[i], "--metrics")) {
+        binary = true; metrics_period_ms = DEF_METRICS_PERIOD_MS;
+        if (is_full_int_arg(argv[i], "--metrics")) metrics_period_ms = parse_int_arg(argv[i], "--metrics");
+      }
       else if (is_int_arg(argv[i], "--auto_wait")) {
         auto_wait = true;
         if (is_full_int_arg(argv[i], "--auto_wait")) def_wait_ms = parse_int_arg(argv[i], "--auto_wait");
       } else if (is_int_arg(argv[i], "--recv_timeout")) {
         recv_timeout = DEF_RECV_TIMEOUT_MS;
         if (is_full_int_arg(argv[i], "--recv_timeout")) recv_timeout = parse_int_arg(argv[i], "--recv_timeout");
+      } else if (is_full_int_arg(argv[i], "--ready_timeout")) {
+        ready_timeout = parse_int_arg(argv[i], "--ready_timeout");
       } else if (is_full_int_arg(argv[i], "--speed")) {
         speed = parse_int_arg(argv[i], "--speed");
       }
 #else
       else if (strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "--binary") == 0) binary = true;
+      else if (strcmp(argv[i], "--pty") == 0) pty = true;
+      else if (is_full_int_arg(argv[i], "--persist")) persist_path = argv[i] + strlen("--persist") + 1;
 #endif
       else usage();
     } else com_file_or_path = argv[i];
@@ -265,7 +366,8 @@ int main(int argc, const char **argv) {
 
 #ifdef DEMO_CLIENT
   const bool client = true;
-  std::string role = binary ? "binary demo client" : "text client";
+  std::string role = metrics_period_ms ? "metrics client" : binary ? "binary demo client" : "text client";
+  MetricsDaemon metrics(metrics_period_ms, metrics_file);
 #else
   const bool client = false;
   std::string role = binary ? "binary server" : "text server";
@@ -273,6 +375,13 @@ int main(int argc, const char **argv) {
 
   if (!quiet) std::cout << "ArduMon " << role << "\n";
 
+#ifndef DEMO_CLIENT
+  if (!persist_path.empty()) {
+    if (!persist_file.open(persist_path.c_str())) { perror(("error opening " + persist_path).c_str()); exit(1); }
+    persist_storage = &persist_file; //setup() restores the params from it
+  }
+#endif
+
   if (!client || binary) setup(); //call Arduino setup() method defined in demo.h
 
 #ifndef DEMO_CLIENT
@@ -280,7 +389,7 @@ int main(int argc, const char **argv) {
     std::cout << "registered " << static_cast<int>(am.getNumCmds())
               << "/" << static_cast<int>(am.getMaxNumCmds()) << " command handlers\n";
   }
-  const bool is_socket = true;
+  const bool is_socket = !pty;
   if (binary) {
     if (!quiet) std::cout << "switching to binary mode\n";
     am.setBinaryMode(true);
@@ -312,27 +421,63 @@ int main(int argc, const char **argv) {
     if (!quiet) std::cout << com_path << " exists and is empty, removing\n";
     unlink(com_path.c_str());
   }
-  listen_fileno = socket(AF_UNIX, SOCK_STREAM, 0);
-  if (listen_fileno < 0) { perror(("error opeining " + com_path).c_str()); exit(1); }
-  if (bind(listen_fileno, (const struct sockaddr *) &addr, sizeof(struct sockaddr_un)) < 0) {
-    perror(("error binding " + com_path).c_str()); exit(1);
-  }
-  if (listen(listen_fileno, 1) < 0) { perror(("error listening on " + com_path).c_str()); exit(1); }
 
-  if (!quiet) {
-    std::cout << role << ": waiting for connection on " << com_path << "...\n";
-    std::cout << "example connection(s):\n";
-    if (binary) std::cout << "ardumon_client --binary_demo unix#" << com_path << "\n";
-    else {
-      std::cout << "minicom -D unix#" << com_path << "\n";
-      std::cout << "ardumon_client unix#" << com_path << " < ardumon_script.txt\n";
+  if (pty) { //text or binary server: create a pseudo terminal and link com_path to it, e.g. to test SerialPort.h
+
+    com_fileno = posix_openpt(O_RDWR | O_NOCTTY);
+    if (com_fileno < 0 || grantpt(com_fileno) != 0 || unlockpt(com_fileno) != 0) {
+      perror("error creating pseudo terminal"); exit(1);
+    }
+    const std::string slave_path = ptsname(com_fileno);
+    pty_slave_fileno = open(slave_path.c_str(), O_RDWR | O_NOCTTY);
+    if (pty_slave_fileno < 0) { perror(("error opening " + slave_path).c_str()); exit(1); }
+
+    //a client normally also does this, but the server may send e.g. the text prompt before the client opens the pty
+    struct termios t;
+    if (tcgetattr(pty_slave_fileno, &t) != 0) { perror(("error getting attribs on " + slave_path).c_str()); exit(1); }
+    cfmakeraw(&t);
+    if (tcsetattr(pty_slave_fileno, TCSANOW, &t) != 0) {
+      perror(("error setting attribs on " + slave_path).c_str()); exit(1);
+    }
+
+    struct stat st;
+    if (lstat(com_path.c_str(), &st) == 0 && S_ISLNK(st.st_mode)) unlink(com_path.c_str()); //stale link
+    if (symlink(slave_path.c_str(), com_path.c_str()) != 0) { perror(("error linking " + com_path).c_str()); exit(1); }
+
+    if (!quiet) {
+      std::cout << role << ": " << com_path << " -> " << slave_path << "\n";
+      std::cout << "example connection:\n";
+      std::cout << "ardumon_client " << (binary ? "--binary_demo " : "") << com_path;
+      std::cout << (binary ? "" : " < ardumon_script.txt") << "\n" << std::flush;
+    }
+
+  } else {
+
+    listen_fileno = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fileno < 0) { perror(("error opeining " + com_path).c_str()); exit(1); }
+    if (bind(listen_fileno, (const struct sockaddr *) &addr, sizeof(struct sockaddr_un)) < 0) {
+      perror(("error binding " + com_path).c_str()); exit(1);
     }
-    std::cout << std::flush;
+    if (listen(listen_fileno, 1) < 0) { perror(("error listening on " + com_path).c_str()); exit(1); }
+
+    if (!quiet) {
+      std::cout << role << ": waiting for connection on " << com_path << "...\n";
+      std::cout << "example connection(s):\n";
+      if (binary) std::cout << "ardumon_client --binary_demo unix#" << com_path << "\n";
+      else {
+        std::cout << "minicom -D unix#" << com_path << "\n";
+        std::cout << "ardumon_client unix#" << com_path << " < ardumon_script.txt\n";
+      }
+      std::cout << std::flush;
+    }
+
+    com_fileno = accept(listen_fileno, NULL, NULL);
+    if (com_fileno < 0) { perror(("error accepting connection on " + com_path).c_str()); exit(1); }
+    if (!quiet) std::cout << "got connection on " << com_path << "\n";
+
   }
 
-  com_fileno = accept(listen_fileno, NULL, NULL);
-  if (com_fileno < 0) { perror(("error accepting connection on " + com_path).c_str()); exit(1); }
-  if (!quiet) std::cout << "got connection on " << com_path << "\n";
+  demo_stream.refill = refillDemoStream;
 
 #else //DEMO_CLIENT
 
@@ -353,22 +498,27 @@ int main(int argc, const char **argv) {
     memcpy(&orig_attribs, &t, sizeof(struct termios)); read_orig_attribs = true;
 
     cfmakeraw(&t); //put the serial port in "raw" binary mode
+    t.c_cc[VMIN] = 1; t.c_cc[VTIME] = 0; //no inter-byte timer, return each read as soon as any bytes are available
 
     if (cfsetspeed(&t, speed) != 0){
       perror(("error settig " + std::to_string(speed) + "baud on " + com_path).c_str());
       exit(1);
     }
 
-    //disabling HUPCL (hang up on close) like this should be equivalent to stty -hupcl
-    //t.c_cflag &= ~HUPCL;
-    //that should prevent the serial port from twiddling DTR on connect and consequently resetting the Arduino
-    //however, it is now too late: we already opened the port and the twiddling already occurred!
+    //disabling HUPCL (hang up on close) like this is equivalent to stty -hupcl
+    //that prevents the serial port from twiddling DTR on connect and consequently resetting the Arduino
+    //however, it is too late for this connection: we already opened the port and the twiddling already occurred
+    //but the setting persists, also when the original attributes are restored, so later connections will not reset
+    t.c_cflag &= ~HUPCL;
+    orig_attribs.c_cflag &= ~HUPCL;
 
     if (tcsetattr(com_fileno, TCSANOW, &t) != 0) { perror(("error setting attribs on " + com_path).c_str()); exit(1); }
 
-    //if the Arduino was reset when we opened the serial port we now need to wait a bit
-    std::cerr << "delaying 5s...\n";
-    sleep_ms(5000);
+    const bool low_latency = serial.lowLatency(com_fileno);
+    if (verbose) std::cout << "low latency mode " << (low_latency ? "enabled" : "not supported") << "\n";
+
+    //if the Arduino was reset when we opened the serial port we need to wait for it to boot, see wait_ready() below
+    probe_ready = true;
   }
 
   if (!binary) {
@@ -386,6 +536,21 @@ int main(int argc, const char **argv) {
 
   fcntl(com_fileno, F_SETFL, O_NONBLOCK);
 
+#ifdef DEMO_CLIENT
+  if (probe_ready) {
+    if (!quiet) std::cout << "waiting for " << com_path << " to be ready...\n" << std::flush;
+    const uint64_t start = millis();
+    if (!wait_ready(binary ? binary_ready_probe() : TEXT_READY_PROBE, ready_timeout)) {
+      std::cerr << "no response from " << com_path << " in " << ready_timeout << "ms, proceeding anyway\n";
+    } else if (!quiet) std::cout << com_path << " ready in " << (millis() - start) << "ms\n";
+  }
+  if (!is_socket) serial.start(com_fileno); //after wait_ready(), which reads com_fileno directly
+#endif
+
+#ifdef DEMO_CLIENT
+  if (metrics_period_ms) am.setUniversalRunnable(&metrics); //metrics client handles all received packets
+#endif
+
   const auto log = [&](const char *what, const uint8_t b) {
     if (verbose) {
       const std::string pad = b < 10 ? "  " : b < 100 ? " " : "";
@@ -396,24 +561,64 @@ int main(int argc, const char **argv) {
   };
 
   auto script_step = script.begin();
-  std::string script_response;
+  std::string script_send, script_response;
   uint64_t wait_start = 0, recv_deadline = 0; uint32_t wait_ms = 0;
 
+  //number of sent commands whose end of response marker has not yet been received, only counted if use_end_marker
+  uint32_t pending_responses = 0;
+
+  //pop the next complete response line or end of response marker from the beginning of script_response
+  //end of response markers are always removed, but only counted if use_end_marker
+  //returns 1 for a line, 2 for a marker, 0 if neither has been completely received yet
+  const auto pop_response = [&](std::string &line) -> int {
+    while (demo_stream.in.size()) script_response += demo_stream.in.get();
+    const size_t nl = script_response.find('\n');
+    const size_t mk = end_marker.empty() ? std::string::npos : script_response.find(end_marker);
+    if (mk != std::string::npos && (nl == std::string::npos || mk < nl)) {
+      script_response.erase(0, mk + end_marker.length()); //also drop anything before the marker, e.g. a prompt
+      if (use_end_marker && pending_responses > 0) --pending_responses;
+      return 2;
+    }
+    if (nl == std::string::npos) return 0;
+    line = script_response.substr(0, nl + 1);
+    script_response.erase(0, nl + 1);
+    while (line.back() == '\n' || line.back() == '\r') line.pop_back();
+    return 1;
+  };
+
   while (!demo_done || demo_stream.out.size()) {
 
-    //move any incoming bytes waiting in com_fileno to demo_stream.in
-    int nr = read(com_fileno, buf, std::min(sizeof(buf), demo_stream.in.free()));
-    if (nr < 0) {
+    //move any incoming bytes waiting in com_fileno, or already taken from it by the serial reader thread, to
+    //demo_stream.in
+    int nr;
+#ifdef DEMO_CLIENT
+    if (serial.running()) {
+      uint64_t arrival_us = 0;
+      nr = serial.read(reinterpret_cast<uint8_t*>(buf), std::min(sizeof(buf), demo_stream.in.free()), &arrival_us);
+      if (nr < 0 && serial.error() == EIO) break; //hung up, e.g. the device was unplugged or the pty was closed
+      if (nr < 0) { errno = serial.error(); perror(("error reading from " + com_path).c_str()); exit(1); }
+      if (verbose && nr > 0) std::cout << role << " rcvd " << (micros() - arrival_us) << "us after arrival\n";
+    } else
+#endif
+    if ((nr = read(com_fileno, buf, std::min(sizeof(buf), demo_stream.in.free()))) < 0) {
       if (errno == ECONNRESET || errno == ENOTCONN) break;
       else if (errno == EAGAIN) nr = 0; //nonblocking read failed due to nothing available to read
       else { perror(("error reading from " + com_path).c_str()); exit(1); }
     }
-    for (size_t i = 0; i < nr; i++) { demo_stream.in.put(buf[i]); if (verbose) log("rcvd", buf[i]); }
+    for (int i = 0; i < nr; i++) { demo_stream.in.put(buf[i]); if (verbose) log("rcvd", buf[i]); }
 
     //move any outgoing bytes waiting in demo_stream.out to com_fileno
     size_t ns = std::min(demo_stream.out.size(), sizeof(buf)), nw = 0;
     if (ns > 0) {
       for (size_t i = 0; i < ns; i++) { buf[i] = demo_stream.out.get(); if (verbose) log("sent", buf[i]); }
+#ifdef DEMO_CLIENT
+      if (serial.running()) {
+        if (!serial.write(reinterpret_cast<uint8_t*>(buf), ns)) {
+          perror(("error writing to " + com_path).c_str()); exit(1);
+        }
+        nw = ns;
+      }
+#endif
       while (ns - nw > 0) {
         int ret = write(com_fileno, buf + nw, ns - nw);
         if (ret < 0) {
@@ -428,15 +633,25 @@ int main(int argc, const char **argv) {
 
     if (verbose && (nr > 0 || nw > 0)) status();
 
+#ifdef DEMO_CLIENT
+    if (metrics_period_ms) { //metrics client: run until killed, or until a fatal error
+      am.update();
+      if (!metrics.tick(am)) exit(1);
+    } else
+#endif
     if (!client || binary) loop(); //call Arduino loop() method defined in demo.h
     else { //demo client text script mode
       const uint64_t now = millis();
-      if (script_step == script.end()) { demo_done = true; break; }
+      //command lines can be longer than demo_stream.out, e.g. for streaming commands, see setStreaming()
+      size_t np = std::min(script_send.length(), demo_stream.out.free());
+      for (size_t i = 0; i < np; i++) demo_stream.out.put(script_send[i]);
+      script_send.erase(0, np);
+      if (script_step == script.end()) { if (script_send.empty()) { demo_done = true; break; } else continue; }
       const size_t step_num = script_step - script.begin();
       if (script_step->first == "send") {
         if (!quiet) std::cout << "script step " << step_num << " SEND " << script_step->second << "\n" << std::flush;
-        nr = script_step->second.length() + 1;
-        for (size_t i = 0; i < nr; i++) demo_stream.out.put((i == nr - 1) ? '\n' : script_step->second[i]);
+        script_send += script_step->second + '\n'; //sent below as space becomes available in demo_stream.out
+        if (use_end_marker) ++pending_responses;
         ++script_step;
       } else if (script_step->first == "recv") {
         if (recv_deadline) {
@@ -457,13 +672,16 @@ int main(int argc, const char **argv) {
           if (recv_timeout > 0) recv_deadline = now + recv_timeout;
           else recv_deadline = std::numeric_limits<uint64_t>::max();
         }
-        while (demo_stream.in.size()) script_response += demo_stream.in.get();
-        auto start = script_response.begin(), end = script_response.end();
-        if (start < end) end = std::find(start, end, '\n');
-        if (end != script_response.end()) {
-          std::string response_line(start, ++end); //pop first response_line from beginning of script_response
-          script_response.erase(start, end);
-          while (response_line.back() == '\n' || response_line.back() == '\r') response_line.pop_back();
+        std::string response_line; int popped;
+        while ((popped = pop_response(response_line)) == 2) {
+          if (use_end_marker && pending_responses == 0) { //fail fast instead of waiting for the receive timeout
+            std::cerr << "ERROR: script step " << step_num << " RECV missing:\n"
+                      << "expected: " << script_step->second << "\n"
+                      << "received end of response\n";
+            exit(1);
+          }
+        }
+        if (popped) {
           if (script_step == script.end() || script_step->first != "recv") {
             std::cerr << "ERROR: received extra line at script step " << step_num << ":\n"
                       << "received: " << response_line << "\n";
@@ -483,10 +701,19 @@ int main(int argc, const char **argv) {
         if (!wait_start) {
           if (!quiet) std::cout << "script step " << step_num << " WAIT " << script_step->second << "\n" << std::flush;
           wait_start = now; wait_ms = parse_int(script_step->second.c_str(), "wait");
-        } else if (now - wait_start > wait_ms) { demo_stream.in.clear(); wait_start = 0; ++script_step; }
+        } else {
+          //with use_end_marker the wait ends early once all responses are complete
+          std::string discard; while (pop_response(discard)) ;
+          if ((use_end_marker && pending_responses == 0) || now - wait_start > wait_ms) {
+            script_response.clear(); wait_start = 0; ++script_step;
+          }
+        }
       }
     }
-    
+
+#ifdef DEMO_CLIENT
+    if (serial.running()) serial.wait(1000); else //wake as soon as more bytes arrive
+#endif
     sleep_ms(1);
   }
 
@@ -0,0 +1,185 @@
+#ifndef AM_METRICS_H
+#define AM_METRICS_H
+
+/**
+ * ArduMon: Yet another Arduino serial command library.
+ *
+ * See https://github.com/martyvona/ArduMon/blob/main/README.md
+ *
+ * This is the metrics daemon of the native binary client, enabled with the --metrics option of ardumon_client.
+ *
+ * It connects to a binary server that registers ArduMon::getStatsHandler() as the "stats" command, and periodically
+ * polls the device performance counters together with the float param of the demo server, if it has the gfp command.
+ * Both are requested in one compound packet, see ArduMon::getCompoundHandler(), so each poll costs one round trip.  The
+ * codes of the stats, cmp, and gfp commands are looked up once at startup with the gcc command, whose own code is
+ * taken from demo_cmds.h.
+ *
+ * The device only sends raw counters, which wrap around at 32 bits.  Rates, mean handler latency over each polling
+ * interval, and 64 bit totals are computed here on the host.  The results are written in the Prometheus text
+ * exposition format, either to stdout or to a file that is atomically replaced after each poll, e.g. for the node
+ * exporter textfile collector.
+ *
+ * This file is designed to be included only in demo.cpp with DEMO_CLIENT defined.
+ *
+ * Copyright 2025 Marsette A. Vona (martyvona@gmail.com)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the “Software”), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <sstream>
+#include <cstdio>
+
+class MetricsDaemon : public AM::Runnable {
+public:
+
+  MetricsDaemon(const uint32_t _period_ms, const std::string &_path) : period_ms(_period_ms), path(_path) {}
+
+  //call after am.update() in the main loop; returns false on a fatal error
+  bool tick(AM &am) {
+    if (failed) return false;
+    const uint64_t now = millis();
+    if (state < NUM_CODES) {
+      if (waiting) return !(timedOut(now) && fail("no response to gcc"));
+      print(F("metrics: sending gcc (")); print(demo_cmds::GCC); print(F(") for cmd ")); print(CMD_NAMES[state]);
+      println();
+      return start(am, now, am.sendCode(demo_cmds::GCC).send(CMD_NAMES[state]).sendPacket());
+    }
+    if (waiting) return !(timedOut(now) && fail("no response to poll"));
+    if (last_poll_ms && now - last_poll_ms < period_ms) return true;
+    last_poll_ms = now;
+    am.sendCode(codes[CMP]).send(static_cast<uint8_t>(0));
+    am.send(static_cast<uint8_t>(1)).sendCode(codes[STATS]);
+    if (codes[GFP] >= 0) am.send(static_cast<uint8_t>(1)).sendCode(codes[GFP]);
+    return start(am, now, am.sendPacket());
+  }
+
+  //universal handler for all packets from the server
+  bool run(AM &am) {
+    if (!waiting) return am.skip(am.argc()).endHandler(); //unsolicited, e.g. a pushed param
+    waiting = false;
+    if (state < NUM_CODES) {
+      int16_t code; if (!am.recv(code).endHandler()) return false;
+      if (code < 0 && state != GFP) return fail(std::string("server has no command ") + CMD_NAMES[state]);
+      codes[state++] = code; //the float param is optional
+      return true;
+    }
+    return recvPoll(am);
+  }
+
+private:
+
+  enum { STATS, CMP, GFP, NUM_CODES };
+  static constexpr const char *CMD_NAMES[NUM_CODES] = { "stats", "cmp", "gfp" };
+  static const uint32_t TIMEOUT_MS = 5000;
+
+  const uint32_t period_ms;
+  const std::string path;
+
+  uint8_t state = 0;
+  int16_t codes[NUM_CODES] = {}; //-1 if the server has no such command
+  bool waiting = false, failed = false;
+  uint64_t sent_ms = 0, last_poll_ms = 0;
+
+  //previous raw counters, and host side totals that do not wrap
+  bool have_prev = false;
+  AM::Stats prev;
+  uint64_t prev_ms = 0;
+  uint64_t cmds = 0, errors = 0, recv_bytes = 0, send_bytes = 0;
+
+  bool start(AM &am, const uint64_t now, const bool sent) {
+    if (!sent) return fail(AM::errMsg(am.clearErr()));
+    waiting = true; sent_ms = now;
+    return true;
+  }
+
+  bool timedOut(const uint64_t now) { return now - sent_ms > TIMEOUT_MS; }
+
+  bool fail(const std::string &msg) { std::cerr << "ERROR: metrics: " << msg << "\n"; failed = true; return false; }
+
+  //compound response: [2] [28] [err] [stats fields] [4] [err] [float param]
+  //or without the gfp command: [1] [28] [err] [stats fields]
+  bool recvPoll(AM &am) {
+    const uint64_t now = millis();
+    const bool with_fp = codes[GFP] >= 0;
+    uint8_t n, len, err; AM::Stats s; float fp = 0;
+    if (!am.recv(n).recv(len).recv(err)) return false;
+    if (n != (with_fp ? 2 : 1) || len != 28 || err) {
+      am.skip(am.argc()).endHandler(); return fail("bad stats response");
+    }
+    am.recv(s.cmds).recv(s.errors).recv(s.recv_bytes).recv(s.send_bytes);
+    am.recv(s.handler_us).recv(s.handler_max_us).recv(s.recv_high).recv(s.send_high);
+    if (with_fp && !am.recv(len).recv(err)) return false;
+    if (with_fp && (len != 4 || err || !am.recv(fp))) {
+      am.skip(am.argc()).endHandler(); return fail("bad gfp response");
+    }
+    if (!am.endHandler()) return false;
+    return write(s, with_fp, fp, now);
+  }
+
+  bool write(const AM::Stats &s, const bool with_fp, const float fp, const uint64_t now) {
+
+    const double dt = have_prev && now > prev_ms ? (now - prev_ms) / 1000.0 : 0;
+
+    //unsigned 32 bit differences are correct across one wraparound of the device counters
+    const uint32_t d_cmds = s.cmds - (have_prev ? prev.cmds : 0);
+    const uint32_t d_errors = s.errors - (have_prev ? prev.errors : 0);
+    const uint32_t d_recv = s.recv_bytes - (have_prev ? prev.recv_bytes : 0);
+    const uint32_t d_send = s.send_bytes - (have_prev ? prev.send_bytes : 0);
+    const uint32_t d_us = s.handler_us - (have_prev ? prev.handler_us : 0);
+    cmds += d_cmds; errors += d_errors; recv_bytes += d_recv; send_bytes += d_send;
+
+    std::ostringstream o;
+    const auto metric = [&](const char *name, const char *type, const char *help, const double v) {
+      o << "# HELP ardumon_" << name << " " << help << "\n";
+      o << "# TYPE ardumon_" << name << " " << type << "\n";
+      o << "ardumon_" << name << " " << v << "\n";
+    };
+
+    metric("commands_total", "counter", "Commands handled by the device.", cmds);
+    metric("errors_total", "counter", "Errors on the device.", errors);
+    metric("receive_bytes_total", "counter", "Bytes received by the device.", recv_bytes);
+    metric("send_bytes_total", "counter", "Bytes sent by the device.", send_bytes);
+    if (dt > 0) {
+      metric("commands_per_second", "gauge", "Command rate over the last polling interval.", d_cmds / dt);
+      metric("errors_per_second", "gauge", "Error rate over the last polling interval.", d_errors / dt);
+      metric("receive_bytes_per_second", "gauge", "Receive rate over the last polling interval.", d_recv / dt);
+      metric("send_bytes_per_second", "gauge", "Send rate over the last polling interval.", d_send / dt);
+    }
+    if (d_cmds > 0) {
+      metric("handler_mean_seconds", "gauge", "Mean handler time over the last polling interval.",
+             1e-6 * d_us / d_cmds);
+    }
+    metric("handler_max_seconds", "gauge", "Longest handler time since the device counters were cleared.",
+           1e-6 * s.handler_max_us);
+    metric("receive_buffer_high_bytes", "gauge", "Receive buffer high water mark.", s.recv_high);
+    metric("send_buffer_high_bytes", "gauge", "Send buffer high water mark.", s.send_high);
+    if (with_fp) metric("float_param", "gauge", "Value of the demo float param.", fp);
+    metric("poll_seconds", "gauge", "Round trip time of the last poll.", (now - sent_ms) / 1000.0);
+
+    prev = s; prev_ms = now; have_prev = true;
+
+    if (path.empty()) { std::cout << o.str() << "\n" << std::flush; return true; }
+
+    //write a temp file and rename it so that readers never see a partial file
+    const std::string tmp = path + ".tmp";
+    std::ofstream f(tmp, std::ios::trunc);
+    if (!(f << o.str()) || (f.close(), !f)) return fail("error writing " + tmp);
+    if (rename(tmp.c_str(), path.c_str()) != 0) return fail("error renaming " + tmp + " to " + path);
+    return true;
+  }
+};
+
+constexpr const char *MetricsDaemon::CMD_NAMES[];
+
+#endif //AM_METRICS_H
@@ -40,7 +40,13 @@ ArduMonTimer<AM> timer;
 
 bool help(AM &am) { return am.sendCmds().endHandler(); }
 
-bool setQuiet(AM &am) { return am.setTextEcho(false).setTextPrompt(static_cast<const char *>(0)).endHandler(); }
+bool setQuiet(AM &am) {
+  bool end_marker = false; //also enable the end of response marker, for automation like ardumon_client
+  if (am.argc() > 1 && !am.skip().recv(end_marker)) return false;
+  if (end_marker) am.setTextEndMarker(F(TEXT_END_MARKER));
+  else am.setTextEndMarker(static_cast<const char *>(0));
+  return am.setTextEcho(false).setTextPrompt(static_cast<const char *>(0)).endHandler();
+}
 
 bool argc(AM &am) { return am.send(am.argc()).endHandler(); }
 
@@ -153,9 +159,69 @@ float float_param = 0;
 bool setFloatParam(AM &am) { return am.skip().recv(float_param).endHandler(); }
 bool getFloatParam(AM &am) { return am.skip().send(float_param).endHandler(); }
 
+//the same handlers are also registered as subcommands "set" and "get" of the command group "fp"
+AM::CmdGroup<2> fp_cmds;
+
+//float_param is also watched as param 0, so that binary clients can cache it, see ArduMonParams.h
+ArduMonParams<AM, 1> params;
+
+//float_param is also persisted in the background so that it survives a reset, see ArduMonPersist.h
+//on AVR it is stored in the EEPROM, the native server stores it in the file given by --persist
+//see native/FileStorage.h
+ArduMonPersist<1> persist;
+#if defined(ARDUINO) && defined(__AVR__)
+ArduMonEEPROM eeprom;
+ArduMonStorage *persist_storage = &eeprom;
+#else
+ArduMonStorage *persist_storage = 0;
+#endif
+
+//a telemetry record: "tm mask [period_ms]" sends just the fields selected by mask, see ArduMonRecord.h
+//the fields are listed by index in native/demo_cmds.txt
+struct Telemetry {
+  uint32_t uptime_ms;
+  float float_param;
+  uint16_t num_errors;
+  uint32_t cmds, recv_bytes, send_bytes; //see AM::Stats
+  uint16_t recv_high, send_high;
+} telemetry;
+
+void refreshTelemetry() {
+  const AM::Stats &s = am.getStats();
+  telemetry.uptime_ms = millis(); telemetry.float_param = float_param; telemetry.num_errors = num_errors;
+  telemetry.cmds = s.cmds; telemetry.recv_bytes = s.recv_bytes; telemetry.send_bytes = s.send_bytes;
+  telemetry.recv_high = s.recv_high; telemetry.send_high = s.send_high;
+}
+
+ArduMonRecord<AM, Telemetry> telemetry_rec(telemetry, refreshTelemetry);
+
+//conflating send slots for packets that the server sends unprompted, see ArduMonSlots.h
+ArduMonSlots<AM, 2, 48> send_slots;
+
+//a deliberately slow computation to demonstrate offloading a binary command to a worker thread, see ArduMonOffload.h
+using Offload = ArduMonOffload<AM>;
+Offload offload;
+bool sumSquares(Offload::Job &job) {
+  uint32_t n; if (!job.get(n)) return false;
+  uint64_t sum = 0;
+  for (uint32_t i = 0; i < n; i++) sum += static_cast<uint64_t>(i) * i;
+  return job.put(sum);
+}
+Offload::Cmd sum_squares_cmd(offload, sumSquares);
+
+//a streaming command: its arguments are received one at a time as they arrive, so there can be more of them than would
+//fit in recv_buf; in binary mode the checksum is verified only at the end, see ArduMon::setStreaming()
+bool sum(AM &am) {
+  uint16_t n = 0; int32_t sum = 0;
+  for (am.skip(); am.hasArg(); n++) { int32_t v; if (!am.recv(v)) return false; sum += v; }
+  if (!am.recvChecksum()) return false; //abort without responding if the packet was corrupted
+  return am.send(n).send(sum).endHandler();
+}
+
 bool quit(AM &am) {
   print(am.isBinaryMode() ? F("binary") : F("text")); print(F(" server done, "));
   print(num_errors); print(F(" total errors")); println();
+  persist.flush(); //commit a float_param change which is still waiting for its delay
   demo_done = true;
   return true;
 }
@@ -167,7 +233,7 @@ void addCmds() {
 
   ADD_CMD(gcc, "gcc", "name | get command code");
   ADD_CMD(help, "help", "show commands");
-  ADD_CMD(setQuiet, "quiet", "disable text echo and prompt");
+  ADD_CMD(setQuiet, "quiet", "[end_marker] | disable text echo and prompt, optionally enable end of response marker");
   ADD_CMD(argc, "argc", "show arg count");
   ADD_CMD(&(timer.start_cmd), "ts", "hours mins secs [accel [sync_throttle_ms|-1 [bin_response_code]]] | start timer");
   ADD_CMD(&(timer.stop_cmd), "to", "stop timer");
@@ -194,7 +260,26 @@ void addCmds() {
   ADD_CMD(echoMultiple, "em", "format_string args... | echo multiple args based on format");
   ADD_CMD(setFloatParam, "sfp", "arg | set float param");
   ADD_CMD(getFloatParam, "gfp", "get float param");
+  if (!am.addGroup(fp_cmds, F("fp"), F("float param commands"))) { print(AM::errMsg(am.clearErr())); println(); }
+  ADD_CMD(setFloatParam, "fp.set", "arg | set float param");
+  ADD_CMD(getFloatParam, "fp.get", "get float param");
   ADD_CMD(quit, "quit", "quit");
+  ADD_CMD(am.getCompoundHandler(), "cmp", "binary only | run multiple commands from one packet");
+  ADD_CMD(&(params.get_cmd), "pg", "id [watch] | get param, in binary mode also send changes iff watch (default 1)");
+  ADD_CMD(&sum_squares_cmd, "ssq", "binary only | n | sum of squares below n, computed on a worker thread");
+  ADD_CMD(am.getStatsHandler(), "stats", "get performance counters");
+  ADD_CMD(am.getReadyHandler(), "ready", "respond ready");
+  ADD_CMD(am.getCmdHashHandler(), "hash", "get command table hash");
+  ADD_CMD(sum, "sum", "args... | sum any number of int32 args");
+  if (!am.setStreaming(F("sum"))) { print(AM::errMsg(am.clearErr())); println(); }
+  ADD_CMD(&(telemetry_rec.get_cmd), "tm", "mask [period_ms] | get telemetry, in binary mode also every period_ms");
+  ADD_CMD(am.getBenchHandler(), "bench", "[n] | time codec paths n times (default 100), see getBenchHandler()");
+  params.add(float_param);
+  persist.add(float_param);
+  telemetry_rec.add(telemetry.uptime_ms); telemetry_rec.add(telemetry.float_param);
+  telemetry_rec.add(telemetry.num_errors); telemetry_rec.add(telemetry.cmds);
+  telemetry_rec.add(telemetry.recv_bytes); telemetry_rec.add(telemetry.send_bytes);
+  telemetry_rec.add(telemetry.recv_high); telemetry_rec.add(telemetry.send_high);
 
 #undef ADD_CMD
 }
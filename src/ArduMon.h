@@ -38,6 +38,20 @@
 #error "only little endian architectures are supported"
 #endif
 
+//the text scanning and checksum kernels scanSpecial() and sum8() process multiple bytes per step where possible:
+//16 bytes with SSE2 or NEON in native x86 or 64 bit ARM builds, 4 or 8 bytes with SWAR on 32 and 64 bit Arduino
+//targets like ESP32 and STM32, and one byte at a time on AVR; define ARDUMON_NO_SIMD to force the bytewise versions
+#if !defined(ARDUMON_NO_SIMD) && !defined(ARDUINO) && defined(__SSE2__)
+#include <emmintrin.h>
+#define ARDUMON_SSE2
+#elif !defined(ARDUMON_NO_SIMD) && !defined(ARDUINO) && defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define ARDUMON_NEON
+#endif
+#if !defined(ARDUMON_NO_SIMD) && UINTPTR_MAX > 0xFFFF
+#define ARDUMON_SWAR
+#endif
+
 #ifndef ARDUINO
 class ArduMonStream { //shim for Arduino Stream in native host build
 public:
@@ -54,7 +68,8 @@ public:
 //
 //see https://github.com/martyvona/ArduMon/blob/main/README.md
 //
-//max_num_cmds is the maximum number of commands that can be registered
+//max_num_cmds is the maximum number of top level commands that can be registered, including command groups
+//each command group (see addGroup()) has its own storage for its subcommands
 //
 //recv_buf_sz is the recieve buffer size in bytes
 //in text mode the receive buffer must be large enough to hold the largest command line
@@ -74,14 +89,36 @@ public:
 //
 //with_binary = false saves ~700 bytes on AVR
 //with_text = false saves ~8k bytes on AVR
-template <uint8_t max_num_cmds = 8, uint16_t recv_buf_sz = 128, uint16_t send_buf_sz = 128,
+//
+//with_code16 = true enables command codes up to 0x7fff, see sendCode(), at the cost of one more byte per command
+//
+//with_stats = true keeps performance counters, see getStats(), at the cost of ~32 bytes RAM
+template <uint16_t max_num_cmds = 8, uint16_t recv_buf_sz = 128, uint16_t send_buf_sz = 128,
           bool with_int64 = true, bool with_float = true, bool with_double = true,
-          bool with_binary = true, bool with_text = true>
+          bool with_binary = true, bool with_text = true, bool with_code16 = false, bool with_stats = false>
 class ArduMon {
+
+  template <bool c, typename T, typename F> struct IfType { using type = T; }; //no <type_traits> on AVR
+  template <typename T, typename F> struct IfType<false, T, F> { using type = F; };
+
 public:
 
   using millis_t = unsigned long;
 
+  //command codes are 8 bit by default, or 15 bit (0 to 0x7fff) if with_code16
+  using cmd_code_t = typename IfType<with_code16, uint16_t, uint8_t>::type;
+
+  static const cmd_code_t MAX_CMD_CODE = with_code16 ? 0x7fff : 0xff;
+
+  //a command name can have at most this many dotted segments, i.e. command groups nest up to MAX_CMD_DEPTH - 1 deep
+  static const uint8_t MAX_CMD_DEPTH = 4;
+
+  //the code of a command preceded by the codes of its enclosing command groups, if any, see getCodePath()
+  struct CodePath {
+    uint8_t n = 0; //number of codes, 0 if none
+    cmd_code_t code[MAX_CMD_DEPTH];
+  };
+
 #ifndef ARDUINO
   using Stream = ArduMonStream;
 #endif
@@ -99,10 +136,10 @@ public:
 
   enum class Error : uint8_t {
     NONE,
-    CMD_OVERFLOW,   //already have max_num_cmds or duplicate command
+    CMD_OVERFLOW,   //already have max_num_cmds, duplicate command, unknown or too deep group, or code > MAX_CMD_CODE
     RECV_OVERFLOW,  //received command longer than recv_buf_sz
     RECV_UNDERFLOW, //received command shorter than expected
-    RECV_TIMEOUT,   //longer than recv_timeout_ms between receiving the first and last bytes of a command
+    RECV_TIMEOUT,   //exceeded recv_timeout_ms for a whole command, or recv_gap_us between bytes of a binary packet
     SEND_OVERFLOW,  //handler attempted to send while send buffer full
     BAD_CMD,        //received command unknown
     BAD_ARG,        //received data failed to parse as expected type
@@ -134,7 +171,6 @@ public:
     setBinaryModeImpl(binary, true, false);
     setUniversalHandler(0);
     setFallbackHandler(0);
-    memset(cmds, 0, sizeof(cmds));
   }
 
 #ifdef ARDUINO
@@ -149,12 +185,12 @@ public:
   //get the underlying stream, e.g. for direct use in command handlers
   Stream *getStream() { return stream; }
 
-  //get the number of registered commands
+  //get the number of registered top level commands, including command groups but not their subcommands
   //this will also be the binary code of the next command that will be added by addCmd() without an explicit code
-  uint8_t getNumCmds() { return n_cmds; }
+  uint16_t getNumCmds() { return cmds.n; }
 
-  //get the maximum number of commands that can be registered
-  uint8_t getMaxNumCmds() { return max_num_cmds; }
+  //get the maximum number of top level commands that can be registered
+  uint16_t getMaxNumCmds() { return max_num_cmds; }
 
   //get the send buffer size in bytes
   uint16_t getSendBufSize() { return send_buf_sz; }
@@ -201,6 +237,43 @@ public:
   //install the default error handler returned by getDefaultErrorHandler()
   ArduMon& setDefaultErrorHandler() { return setErrorHandler(getDefaultErrorHandlerImpl()); }
 
+  //binary mode: automatically send an error response packet when a command fails, in addition to running any error
+  //handler; this lets the client fail fast instead of waiting for a response that will never come
+  //the error response packet is [code] [error] [failed command code] [up to echo_bytes following bytes]
+  //* code is a reserved command code, in the format of sendCode(), which should not start any other response
+  //* error is the Error enum value as one byte
+  //* the failed command code is the first code of the failed packet, again in the format of sendCode()
+  //* the echo bytes are up to echo_bytes bytes of the failed packet following its first code, e.g. a subcommand code
+  //  or a request ID, if the client puts one there; they are omitted for a streaming command, see setStreaming()
+  //the failed command code and echo bytes are omitted for receive errors: RECV_OVERFLOW, RECV_TIMEOUT, BAD_PACKET
+  //a receive error abandons the partial packet and gets one error response, sent after any packet already queued
+  //any partial response from the failed handler is discarded; see recvErrorResponse() to receive it on the client
+  ArduMon& setErrorResponse(const cmd_code_t code, const uint8_t echo_bytes = 0) {
+    err_response_code = code; err_response_echo = echo_bytes; flags |= F_ERR_RESPONSE;
+    return *this;
+  }
+  ArduMon& clearErrorResponse() { flags &= ~F_ERR_RESPONSE; return *this; }
+  bool hasErrorResponse() { return flags&F_ERR_RESPONSE; }
+  cmd_code_t getErrorResponseCode() { return err_response_code; }
+
+  //binary mode: if the received packet is an error response from a peer with setErrorResponse(code), i.e. it starts
+  //with code followed by a valid error byte, then receive the error and the failed command code and return true
+  //cmd is unchanged if the error response does not include a failed command code; any echo bytes can then be received
+  //otherwise return false without receiving anything
+  //this is meant to be called first in a universal handler on the client
+  bool recvErrorResponse(const cmd_code_t code, Error &e, cmd_code_t &cmd) {
+    if (!binary_mode || !with_binary || hasErr()) return false;
+    const uint8_t *p = reinterpret_cast<const uint8_t*>(recv_ptr);
+    const uint8_t nb = (with_code16 && recv_end > recv_ptr && (p[0]&0x80)) ? 2 : 1;
+    if (recv_end - recv_ptr < nb + 1) return false;
+    const uint16_t c = nb == 2 ? ((p[0]&0x7f) << 8) | p[1] : p[0];
+    if (c != code || p[nb] == 0 || p[nb] > static_cast<uint8_t>(Error::UNSUPPORTED)) return false;
+    e = static_cast<Error>(p[nb]);
+    recv_ptr += nb + 1;
+    if (recv_ptr < recv_end) recvCode(cmd);
+    return true;
+  }
+
   //set an error handler that will be called automatically during endHandler() if hasErr()
   //if the error handler returns true then clearErr() will be automatically called
   ArduMon&  setErrorHandler(const handler_t h)  { return setHandler (error_handler,  h, F_ERROR_RUNNABLE); }
@@ -224,91 +297,249 @@ public:
   ArduMon&  setFallbackRunnable(Runnable* const r) { return setRunnable(fallback_runnable, r, F_FALLBACK_RUNNABLE); }
   Runnable* getFallbackRunnable()                  { return getRunnable(fallback_runnable,    F_FALLBACK_RUNNABLE); }
 
+  //performance counters, only kept if with_stats, otherwise always 0
+  //the counters wrap around on overflow, so rates should be computed from unsigned 32 bit differences
+  struct Stats {
+    uint32_t cmds = 0;           //commands dispatched, including unknown commands and compound subcommands
+    uint32_t errors = 0;         //errors, including those of compound subcommands
+    uint32_t recv_bytes = 0;     //bytes read from the stream
+    uint32_t send_bytes = 0;     //bytes written to the stream
+    uint32_t handler_us = 0;     //total microseconds from dispatching commands to the end of their handlers
+    uint32_t handler_max_us = 0; //longest handler in microseconds
+    uint16_t recv_high = 0;      //receive buffer high water mark in bytes
+    uint16_t send_high = 0;      //send buffer high water mark in bytes, binary mode only
+  };
+
+  const Stats& getStats() { return stats.get(); }
+
+  ArduMon& clearStats() { stats.clear(); return *this; }
+
+  //returns a handler that sends the getStats() fields in order, which can be registered with addCmd() like any other
+  //binary mode: 6 uint32_t followed by 2 uint16_t, little endian; text mode: the same separated by spaces
+  handler_t getStatsHandler() {
+    return [](ArduMon &am) -> bool {
+      const Stats &s = am.getStats();
+      return am.skip().send(s.cmds).send(s.errors).send(s.recv_bytes).send(s.send_bytes)
+        .send(s.handler_us).send(s.handler_max_us).send(s.recv_high).send(s.send_high).endHandler();
+    };
+  }
+
+  //returns a handler that times hot paths of this instance on the target, which can be registered with addCmd() like
+  //any other; the command takes an optional uint16_t iteration count n, default 100, and runs each path n times
+  //the response is n followed by the total microseconds taken by each path, in this order, which the host can divide
+  //by n: 32 byte checksum, command lookup, int parse, int format, float parse, float format, tokenizing a command line
+  //command lookup is by code in binary mode and by name in text mode, and is for the last top level command
+  //int and float parse and format are those of the current mode, e.g. a copy in binary mode; the float times are 0
+  //unless with_float; nothing is sent or received by the timed paths and the responses of other commands are unaffected
+  //binary mode: uint16_t followed by 7 uint32_t, little endian; text mode: the same separated by spaces
+  handler_t getBenchHandler() {
+    return [](ArduMon &am) -> bool {
+      uint16_t n = 100;
+      if (am.skip().hasArg() && !am.recv(n)) return false;
+      uint32_t us[7];
+      if (!am.bench(n, us)) return false;
+      am.send(n);
+      for (uint8_t i = 0; i < 7; i++) am.send(us[i]);
+      return am.endHandler();
+    };
+  }
+
+  //announce that the device is ready for commands, typically at the end of the Arduino setup() method
+  //a host that just opened the serial port, which may have reset the Arduino, can wait for this instead of a fixed
+  //delay, and otherwise probe with any command that gets a response, e.g. the handler returned by getReadyHandler()
+  //text mode: send "ready" on its own line, followed by the prompt if any
+  //binary mode: send a packet containing the null terminated string "ready", see recvReady()
+  //noop if a command is currently being handled
+  ArduMon& sendReady() {
+    if (flags&F_HANDLING) return *this;
+    if (binary_mode || !with_text) return send(readyMsg()).sendPacket();
+    return sendCRLF(true).sendRaw(readyMsg()).sendCRLF(true).sendTextPrompt();
+  }
+
+  //returns a handler that responds like sendReady(), which can be registered with addCmd() like any other
+  handler_t getReadyHandler() { return [](ArduMon &am) -> bool { return am.skip().send(readyMsg()).endHandler(); }; }
+
+  //binary mode: if the received packet is a sendReady() announcement then receive it and return true
+  //otherwise return false without receiving anything
+  bool recvReady() {
+    if (!binary_mode || !with_binary || hasErr() || recv_end - recv_ptr != 6) return false;
+    if (strcmp_P(recv_ptr, CCS(readyMsg())) != 0) return false;
+    recv_ptr = recv_end;
+    return true;
+  }
+
+  //returns a handler for compound commands in binary mode, which can be registered with addCmd() like any other
+  //a compound command packet carries multiple subcommands, which are dispatched in order to their usual handlers:
+  //[compound code(s)] [options] [len_1] [subcommand_1] ... [len_n] [subcommand_n]
+  //where each subcommand is len_i bytes starting with its command code(s), and options is a bitmask of COMPOUND_*
+  //the responses are collected into a single packet instead of each subcommand sending its own:
+  //[num records] [data len_1] [error_1] [data_1] ... [data len_m] [error_m] [data_m]
+  //where error_i is the Error of subcommand i as a byte (0 on success) and data_i is what it sent
+  //m < n if COMPOUND_STOP_ON_ERROR and subcommand m failed, or if the response would not fit in the send buffer
+  //subcommand errors are reported in the response instead of to the error handler
+  //with COMPOUND_NO_RESPONSE no response is sent and what the subcommands send is discarded, so that a peer can batch
+  //one-way messages, e.g. setters or notifications, into one packet to save framing overhead
+  //sendPacket() is a noop while running subcommands, and they must call endHandler() before returning
+  //BAD_PACKET if the subcommand lengths don't exactly fill the packet, UNSUPPORTED in text mode or if nested
+  handler_t getCompoundHandler() { return [](ArduMon &am) { return am.handleCompound(); }; }
+
+  static const uint8_t COMPOUND_STOP_ON_ERROR = 0x01; //don't run the remaining subcommands after one fails
+  static const uint8_t COMPOUND_NO_RESPONSE   = 0x02; //don't send a response, see getCompoundHandler()
+
   //add a command: name may be null, but if not, it must be unique relative to already added commands
   //code must be unique relative to already added commands
-  //CMD_OVERFLOW if command with the given name (if any) or code already exists, or if max_num_cmds already added
-  ArduMon& addCmd(const handler_t handler, const char *name, const uint8_t code, const char *description = 0) {
+  //a dotted name like "motor.set" adds the command "set" to the previously added command group "motor"
+  //and then code must only be unique within that group, see addGroup()
+  //CMD_OVERFLOW if command with the given name (if any) or code already exists, if max_num_cmds already added,
+  //if the name refers to an unknown command group, or if code > MAX_CMD_CODE
+  ArduMon& addCmd(const handler_t handler, const char *name, const cmd_code_t code, const char *description = 0) {
     return addCmdImpl(handler, name, code, description, false);
   }
 
-  //add a command using the next available command code
+  //add a command using the next available command code (in its group, if any)
   ArduMon& addCmd(const handler_t handler, const char *name, const char *description = 0) {
-    return addCmdImpl(handler, name, n_cmds, description, false);
+    return addCmdImpl(handler, name, AUTO_CODE, description, false);
   }
 
   //add a command with null name, for binary mode use only
-  ArduMon& addCmd(const handler_t handler, const uint8_t code, const char *description = 0) {
+  ArduMon& addCmd(const handler_t handler, const cmd_code_t code, const char *description = 0) {
     return addCmdImpl(handler, 0, code, description, false);
   }
 
   //add a command with a Runnable instead of a handler_t
-  ArduMon& addCmd(Runnable* const runnable, const char *name, const uint8_t code, const char *description = 0) {
+  ArduMon& addCmd(Runnable* const runnable, const char *name, const cmd_code_t code, const char *description = 0) {
     return addCmdImpl(runnable, name, code, description, false);
   }
 
-  //add a command using the next available command code
+  //add a command using the next available command code (in its group, if any)
   ArduMon& addCmd(Runnable* const runnable, const char *name, const char *description = 0) {
-    return addCmdImpl(runnable, name, n_cmds, description, false);
+    return addCmdImpl(runnable, name, AUTO_CODE, description, false);
   }
 
   //add a command with null name, for binary mode use only
-  ArduMon& addCmd(Runnable* const runnable, const uint8_t code, const char *description = 0) {
+  ArduMon& addCmd(Runnable* const runnable, const cmd_code_t code, const char *description = 0) {
     return addCmdImpl(runnable, 0, code, description, false);
   }
 
-  //remove command registered with given code
-  ArduMon& removeCmd(const uint8_t code) { return removeCmdImpl(code); }
+  struct CmdTable; //a table of commands, see CmdGroup
+
+  //storage for a group of up to max_group_cmds subcommands, see addGroup(); it must outlive its registration
+  template <uint16_t max_group_cmds> struct CmdGroup;
+
+  //add a command group: subcommands can then be added to it with dotted names, e.g. "motor.set"
+  //a group name can itself be dotted to nest groups, e.g. "motor.pid" after adding group "motor", up to MAX_CMD_DEPTH
+  //in text mode a subcommand is invoked either as "motor.set" or as the two separate tokens "motor set"
+  //in binary mode a subcommand is invoked by a packet starting with the group code followed by the subcommand code
+  //either way the command lookup searches only the tables along the path, not all commands
+  //CMD_OVERFLOW under the same conditions as addCmd()
+  ArduMon& addGroup(CmdTable &group, const char *name, const cmd_code_t code, const char *description = 0) {
+    return addCmdImpl(&group, name, code, description, false);
+  }
+
+  //add a command group using the next available command code (in its parent group, if any)
+  ArduMon& addGroup(CmdTable &group, const char *name, const char *description = 0) {
+    return addCmdImpl(&group, name, AUTO_CODE, description, false);
+  }
+
+  //remove top level command or command group registered with given code
+  ArduMon& removeCmd(const cmd_code_t code) { return removeCmdImpl(code); }
 
-  //remove command registered with given name
-  ArduMon& removeCmd(const char *name) { return removeCmdImpl(name); }
+  //remove command or command group registered with given name, which may be dotted
+  ArduMon& removeCmd(const char *name) { return removeCmdImpl(name, false); }
 
-  //remove command registered with given handler
+  //remove top level command registered with given handler
   ArduMon& removeCmd(const handler_t handler) { return removeCmdImpl(handler); }
 
-  //remove command registered with given runnable
+  //remove top level command registered with given runnable
   ArduMon& removeCmd(Runnable* const runnable) { return removeCmdImpl(runnable); }
 
 #ifdef ARDUINO
   //add a command with strings from program memory
-  ArduMon& addCmd(const handler_t handler, const FSH *name, const uint8_t code, const FSH *description = 0) {
+  ArduMon& addCmd(const handler_t handler, const FSH *name, const cmd_code_t code, const FSH *description = 0) {
     return addCmdImpl(handler, CCS(name), code, CCS(description), true);
   }
 
   //add a command using the next available command code with strings from program memory
   ArduMon& addCmd(const handler_t handler, const FSH *name, const FSH *description = 0) {
-    return addCmdImpl(handler, CCS(name), n_cmds, CCS(description), true);
+    return addCmdImpl(handler, CCS(name), AUTO_CODE, CCS(description), true);
   }
 
   //add a command with strings from program memory
-  ArduMon& addCmd(Runnable* const runnable, const FSH *name, const uint8_t code, const FSH *description = 0) {
+  ArduMon& addCmd(Runnable* const runnable, const FSH *name, const cmd_code_t code, const FSH *description = 0) {
     return addCmdImpl(runnable, CCS(name), code, CCS(description), true);
   }
 
   //add a command using the next available command code with strings from program memory
   ArduMon& addCmd(Runnable* const runnable, const FSH *name, const FSH *description = 0) {
-    return addCmdImpl(runnable, CCS(name), n_cmds, CCS(description), true);
+    return addCmdImpl(runnable, CCS(name), AUTO_CODE, CCS(description), true);
+  }
+
+  //add a command group with strings from program memory
+  ArduMon& addGroup(CmdTable &group, const FSH *name, const cmd_code_t code, const FSH *description = 0) {
+    return addCmdImpl(&group, CCS(name), code, CCS(description), true);
+  }
+
+  //add a command group using the next available command code with strings from program memory
+  ArduMon& addGroup(CmdTable &group, const FSH *name, const FSH *description = 0) {
+    return addCmdImpl(&group, CCS(name), AUTO_CODE, CCS(description), true);
   }
 
-  //remove command registered with given name and return true if it was found, false if it was not found
-  ArduMon& removeCmd(const FSH *name) { return removeCmdImpl(name); }
+  //remove command or command group registered with given name, which may be dotted
+  ArduMon& removeCmd(const FSH *name) { return removeCmdImpl(CCS(name), true); }
+#endif
+
+  //make the command with the given name, which may be dotted, streaming, or not
+  //normally a command is buffered until its terminating newline or checksum, so it must fit in recv_buf; a streaming
+  //command is instead dispatched as soon as its name and the following space, or its code, are received, and then its
+  //handler receives each argument directly from the stream as it arrives, blocking until it is complete
+  //only the current argument is buffered, so the argument list can be arbitrarily long in text mode, and up to the
+  //maximum packet size in binary mode regardless of recv_buf_sz; a received string is only valid until the next receive
+  //text mode: the receive timeout, if any, applies per token; the handler should loop on hasArg() rather than using
+  //argc(); the command must be invoked by its full (dotted) name, and line editing is not supported in its arguments
+  //binary mode: the receive timeout, if any, still applies to the whole packet; the checksum is not verified until the
+  //handler calls recvChecksum(); only top level commands are dispatched early, subcommands are still buffered
+  //any unread remainder of the line or packet is discarded after the handler ends
+  //the handler blocks update() and loop() while it waits for input, so a streaming command is only dispatched early
+  //while that wait is bounded by setRecvTimeoutMS(), or in binary mode also by setRecvGapUS(); otherwise it's buffered
+  //BAD_CMD if there is no such command
+  ArduMon& setStreaming(const char *name, const bool streaming = true) {
+    return setStreamingImpl(name, streaming, false);
+  }
+#ifdef ARDUINO
+  ArduMon& setStreaming(const FSH *name, const bool streaming = true) {
+    return setStreamingImpl(CCS(name), streaming, true);
+  }
 #endif
 
-  //get the command code for a command name; returns -1 if not found
-  int16_t getCmdCode(const char *name) { return getCmdCodeImpl<char>(name); }
+  //get the command code for a command name, which may be dotted; returns -1 if not found
+  //for a dotted name this is the code of the subcommand within its group
+  int16_t getCmdCode(const char *name) { return getCmdCodeImpl(name, false); }
 #ifdef ARDUINO
-  int16_t getCmdCode(const FSH *name) { return getCmdCodeImpl<FSH>(name); }
+  int16_t getCmdCode(const FSH *name) { return getCmdCodeImpl(CCS(name), true); }
 #endif
 
-  //get the commad name for a command code; returns null if not found
+  //get the commad name for a top level command code; returns null if not found
   //the returned pointer will be in program memory on AVR if and only if the command was originally registered that way 
-  const char * getCmdName(const uint8_t code) {
-    for (uint8_t i = 0; i < n_cmds; i++) if (cmds[i].code == code) return cmds[i].name;
-    return 0;
+  const char * getCmdName(const cmd_code_t code) {
+    const Cmd *cmd = cmds.find(code);
+    return cmd ? cmd->name : 0;
+  }
+
+  //get a hash of the names and codes of all commands and command groups, independent of the order they were added
+  //a client can compare this to the hash of the command table it was built for to check compatibility
+  //the hash of each command is the 32 bit FNV-1a hash of its dotted name, a 0 byte, and then the code of each group on
+  //its path followed by its own code, each as two bytes little endian; these are summed mod 2^32 over all commands
+  uint32_t getCmdHash() { return cmdHashImpl(cmds, 0); }
+
+  //returns a handler that sends getCmdHash(), which can be registered with addCmd() like any other
+  handler_t getCmdHashHandler() {
+    return [](ArduMon &am) -> bool { return am.skip().send(am.getCmdHash()).endHandler(); };
   }
 
   //noop in binary mode
-  //in text mode send one line per command: cmd_name cmd_code_hex cmd_description
-  ArduMon& sendCmds() { return sendCmdsImpl(); }
+  //in text mode send one line per command: cmd_code_hex cmd_name cmd_description
+  //subcommands are listed after their group with dotted codes and names, e.g. 05.01 motor.set
+  ArduMon& sendCmds() { return sendCmdsImpl(cmds, 0); }
 
   //does nothing if already in the requested mode: binary mode if binary=true, else text mode
   //otherwise the command interpreter and send and receive buffers are reset
@@ -329,6 +560,21 @@ public:
     return *this;
   }
 
+  //text mode: automatically suppress echo and prompt while the received input looks scripted rather than typed, i.e.
+  //while characters arrive with more input already waiting or less than gap_us apart
+  //they are restored, and the prompt is sent again, once nothing has been received for idle_ms
+  //this avoids echoing a script, which doubles the traffic and can block on writes, without an explicit command to
+  //disable echo; line endings and terminal escape sequences, e.g. for the arrow keys, are not taken as scripted input
+  //set idle_ms to 0 to disable this (it's disabled by default)
+  ArduMon& setTextAutoQuiet(const unsigned long gap_us = 5000, const millis_t idle_ms = 1000) {
+    txt_script_gap_us = gap_us; txt_idle_ms = idle_ms;
+    if (!idle_ms) flags &= ~F_TXT_SCRIPTED;
+    return *this;
+  }
+
+  //true while echo and prompt are suppressed because the input looks scripted, see setTextAutoQuiet()
+  bool isTextScripted() { return flags&F_TXT_SCRIPTED; }
+
   //set prompt to NULL to disable it
   //otherwise the new prompt is sent immediately in text mode iff a handler is not currently running
   ArduMon& setTextPrompt(const char *prompt) {
@@ -346,6 +592,42 @@ public:
   }
 #endif
 
+  //set text mode end of response marker to NULL to disable it (it's disabled by default)
+  //otherwise the marker is sent at the end of the response to every received command, including empty and failed
+  //commands, after any error message and before the prompt
+  //this lets automation tell exactly when a response is complete, instead of waiting for a guessed amount of time
+  //the marker is sent as is, e.g. include "\r\n" for a sentinel line, or use an OSC escape sequence like
+  //"\x1b]5379;end\x07" which terminals ignore
+  ArduMon& setTextEndMarker(const char *marker) {
+    txt_end_marker = marker;
+    flags &= ~F_TXT_MARKER_PROGMEM;
+    return *this;
+  }
+
+#ifdef ARDUINO
+  //set text end of response marker from a program memory string
+  ArduMon& setTextEndMarker(const FSH *marker) {
+    txt_end_marker = CCS(marker);
+    flags |= F_TXT_MARKER_PROGMEM;
+    return *this;
+  }
+#endif
+
+  //text mode: a command line may start with an optional request tag token, an '@' followed by a decimal number up to
+  //65535, e.g. "@17 gfp"; the tag is stripped before dispatch and sent at the start of each line of the response,
+  //including any error message and the end of response marker, e.g. "@17 5.875"
+  //so automation can pipeline commands, i.e. send the next ones without waiting for the previous responses, and still
+  //match every response line to its command; this works best with echo and prompt disabled and an end of response
+  //marker, and while a command is handling the following lines wait in the receive buffer of the underlying stream
+  //returns the tag of the command currently being handled, or -1 if none
+  int32_t getTextTag() { return (flags&F_TXT_TAGGED) ? txt_tag : -1; }
+
+  //the code path of the command currently being handled: the codes of its enclosing command groups, if any, and then
+  //its own code; n is 0 if none, e.g. in a universal or fallback handler; valid in both modes until the next dispatch
+  //in binary mode a handler runs with recv_ptr at the last byte of its code, so skip() then moves to its arguments
+  //e.g. a handler can save this to send later notifications with sendCode(path), even if it is a subcommand
+  const CodePath& getCodePath() { return code_path; }
+
   static const millis_t ALWAYS_WAIT = -1; //-1 in base 2 is all 1s as unsigned
 
   //set receive timeout
@@ -356,16 +638,134 @@ public:
   ArduMon& setRecvTimeoutMS(const millis_t ms) { recv_timeout_ms = ms == ALWAYS_WAIT ? 0 : ms; return *this; }
   millis_t getRecvTimeoutMS() { return recv_timeout_ms; }
 
+  //set binary mode inter-byte gap timeout
+  //if the line is idle for this long after receiving part of a packet then the partial packet is discarded with
+  //RECV_TIMEOUT, and the next received byte starts a new packet
+  //this resynchronizes after a dropped byte in a few character times instead of waiting for the claimed packet length
+  //a few character times, e.g. 4 * 10 bits / 115200 baud ~= 350us, is a good choice; the gap is only checked when
+  //update() finds no received bytes waiting, so a slow loop() will not cause false timeouts
+  //set to 0 to disable the gap timeout (it's disabled by default); not used in text mode
+  ArduMon& setRecvGapUS(const unsigned long us) { recv_gap_us = us; return *this; }
+  unsigned long getRecvGapUS() { return recv_gap_us; }
+
   //block for up to this long in send_packet() in binary mode, default 0, use ALWAYS_WAIT to block indefinitely
   //text mode sends always block until space is available in the Arduino serial send buffer
   ArduMon& setSendWaitMS(const millis_t ms) { send_wait_ms = ms; return *this; }
   millis_t getSendWaitMS() { return send_wait_ms; }
 
+  //a token bucket rate limiter on packet bytes, implemented as a virtual schedule in micros(), i.e. GCRA
+  //it admits bursts of up to burst bytes, and on average rate bytes per second; each packet costs its length plus
+  //per_packet bytes, so that per_packet can also limit the packet rate; a packet larger than burst is admitted when
+  //the bucket is full; ArduMon uses one for setSendRate(), and producers can use their own to shape the packets with a
+  //particular command code, e.g. periodic telemetry, before queueing them
+  struct TokenBucket {
+
+    //rate 0 disables the limit
+    void set(const unsigned long rate, const uint16_t burst = 0, const uint8_t per_packet = 0) {
+      //the cost of a byte is kept in 1/256 microseconds so that fast rates, e.g. USB CDC, are not rounded to 1us/byte
+      const unsigned long rem = rate == 0 ? 0 : 1000000UL % rate; //rem < rate
+      us_per_byte = rate == 0 ? 0 : 1000000UL / rate;
+      frac_per_byte = rate == 0 ? 0 : rate <= 0xffffffUL ? (rem << 8) / rate : rem / (rate >> 8);
+      if (rate && !us_per_byte && !frac_per_byte) frac_per_byte = 1; //over 256MB/s
+      const unsigned long max_tau_us = 0x3fffffffUL; //keep the schedule within half the range of micros()
+      tau_us = burst > max_tau_us / (us_per_byte + 1) ? max_tau_us : cost(burst);
+      per_pkt = per_packet; tat = micros(); tat_frac = 0;
+    }
+
+    //microseconds until a packet of len bytes would be admitted, 0 if now
+    unsigned long waitUS(const uint16_t len, const unsigned long now = micros()) const {
+      if (!enabled()) return 0;
+      const unsigned long c = cost(len + per_pkt, tat_frac), tau = c > tau_us ? c : tau_us;
+      return start(now) + c > tau ? start(now) + c - tau : 0;
+    }
+
+    //if a packet of len bytes would be admitted now then charge for it and return true, otherwise return false
+    bool take(const uint16_t len, const unsigned long now = micros()) {
+      if (waitUS(len, now)) return false;
+      if (!enabled()) return true;
+      const uint16_t n = len + per_pkt;
+      const unsigned long f = static_cast<unsigned long>(frac_per_byte) * n + tat_frac;
+      tat = now + start(now) + us_per_byte * n + (f >> 8);
+      tat_frac = f & 0xff; //carry the fraction of a microsecond to the next packet
+      return true;
+    }
+
+  private:
+
+    bool enabled() const { return us_per_byte || frac_per_byte; }
+
+    //microseconds to send n bytes, rounded down, including frac carried 1/256 microseconds
+    unsigned long cost(const uint16_t n, const uint8_t frac = 0) const {
+      return us_per_byte * n + ((static_cast<unsigned long>(frac_per_byte) * n + frac) >> 8);
+    }
+
+    //microseconds that the schedule is ahead of now, i.e. the bucket deficit; 0 if full, also after micros() wrapped
+    unsigned long start(const unsigned long now) const {
+      const unsigned long d = tat - now;
+      return static_cast<long>(d) < 0 || d > tau_us + cost(0xff + per_pkt) + 1 ? 0 : d;
+    }
+
+    unsigned long us_per_byte = 0, tau_us = 0, tat = 0;
+    uint8_t frac_per_byte = 0, tat_frac = 0, per_pkt = 0; //frac_per_byte and tat_frac are in 1/256 microseconds
+  };
+
+  //binary mode: limit the rate at which packets are sent, see TokenBucket; rate 0 (the default) disables the limit
+  //a queued packet is only started when the limit admits it, blocking for up to send_wait_ms in sendPacket(), and
+  //otherwise it stays in the send buffer and is released by a later update(), see getSendWaitUS()
+  //while a packet is held back update() does not dispatch further commands, so that their responses do not fail
+  //SEND_OVERFLOW; the rest of their packets wait in the stream, so the receive timeout should allow for the hold
+  //the limit applies to the start of each packet; it does not pace the bytes within a packet
+  ArduMon& setSendRate(const unsigned long bytes_per_sec, const uint16_t burst_bytes = 0,
+                       const uint8_t per_packet_bytes = 0) {
+    send_rate.set(bytes_per_sec, burst_bytes, per_packet_bytes);
+    return *this;
+  }
+
+  //binary mode: microseconds until setSendRate() admits the packet waiting in the send buffer, if any, otherwise a
+  //packet of len bytes; a producer can use this to schedule its next packet instead of blocking or polling
+  unsigned long getSendWaitUS(const uint16_t len = 0) {
+    const bool waiting = send_read_ptr == send_buf;
+    return send_rate.waitUS(waiting ? static_cast<uint8_t>(send_buf[0]) : len);
+  }
+
   //this must be called from the Arduino loop() method
-  //receive available input bytes from serial stream
+  //receive available input bytes from serial stream, but at most max_recv_bytes of them if that is not 0
   //if the end of a command is received then dispatch and handle it
   //in binary mode then try to send remaining response packet bytes without blocking
-  ArduMon& update() { return updateImpl(); }
+  ArduMon& update(const uint16_t max_recv_bytes = 0) { return updateImpl(max_recv_bytes); }
+
+  //check if update() has anything to do right now: received bytes to process, or a packet to send
+  bool hasPendingWork() {
+    if (stream->available() && !deferDispatch()) return true;
+    if (err_response_pending != Error::NONE && !(flags&F_HANDLING) && send_write_ptr == send_buf + 1) return true;
+    return send_read_ptr != 0 && (send_read_ptr != send_buf || getSendWaitUS() == 0);
+  }
+
+  static const unsigned long NO_DEADLINE = -1; //all 1s as unsigned
+
+  //microseconds until update() needs to be called even if nothing more is received: when a receive timeout expires,
+  //when setSendRate() admits a waiting packet, or when setTextAutoQuiet() restores the prompt; 0 if hasPendingWork(),
+  //NO_DEADLINE if nothing is scheduled
+  //a caller that services several instances, or that can sleep, can use this to decide when to call update() next
+  unsigned long getNextDeadlineUS() {
+    if (hasPendingWork()) return 0;
+    unsigned long us = NO_DEADLINE;
+    const auto until = [&](const unsigned long d) { if (d < us) us = d; };
+    if ((flags&F_RECEIVING) && recv_timeout_ms > 0) {
+      const millis_t now = millis();
+      until(now > recv_deadline ? 0 : (recv_deadline - now) * 1000UL);
+    }
+    if ((flags&F_RECEIVING) && recv_gap_us > 0 && binary_mode) {
+      const unsigned long idle = micros() - recv_last_us;
+      until(idle > recv_gap_us ? 0 : recv_gap_us - idle);
+    }
+    if ((flags&F_TXT_SCRIPTED) && !binary_mode) {
+      const unsigned long idle = micros() - recv_last_us, idle_us = txt_idle_ms * 1000UL;
+      until(idle > idle_us ? 0 : idle_us - idle);
+    }
+    if (send_read_ptr == send_buf) until(getSendWaitUS());
+    return us;
+  }
 
   //reset the command interpreter and the receive buffer
   //if hasErr() and there is an error handler (or Runnable) then run it
@@ -379,6 +779,22 @@ public:
   //blocks for up to send_wait_ms
   ArduMon& sendPacket() { return sendPacketImpl(); }
 
+  //binary mode: send a complete packet, including its length and checksum bytes, as is
+  //this allows a packet to be encoded once and then re-sent, possibly after patching some of its bytes
+  //blocks for up to send_wait_ms
+  //SEND_OVERFLOW if the send buffer is not empty or too small, UNSUPPORTED in text mode or in a compound subcommand
+  ArduMon& sendFramed(const char *packet) {
+    if (!binary_mode || !with_binary || (flags&F_COMPOUND)) return fail(Error::UNSUPPORTED);
+    const uint8_t len = static_cast<uint8_t>(packet[0]);
+    if (send_write_ptr != send_buf + 1 || len < 2 || len > send_buf_sz) return fail(Error::SEND_OVERFLOW);
+    memcpy(send_buf, packet, len);
+    stats.queued(len);
+    send_write_ptr = 0; //disable writing to send buf
+    send_read_ptr = send_buf; //enable reading from send buf
+    pumpSendBuf();
+    return *this;
+  }
+
   //check if a packet is still being sent in binary mode
   //do not write additional data to the send buffer while this is the case
   bool isSendingPacket() { return binary_mode && send_write_ptr == 0; }
@@ -394,6 +810,29 @@ public:
   //in either case the return is only valid while handling a command
   uint8_t argc() { return arg_count; }
 
+  //check if there is anything left to receive while handling a command: another token in text mode, or another byte
+  //in binary mode; this is the way to receive a variable number of arguments of a streaming command, whose argc() is
+  //always 1, see setStreaming(), and it blocks while waiting for the next argument of such a command
+  bool hasArg() {
+    if (hasErr() || !(flags&F_HANDLING)) return false;
+    if (binary_mode || !with_text) return recv_ptr < recv_end || ((flags&F_STREAMING) && stream_left > 0);
+    if (stream_tok && recv_ptr >= stream_tok) return streamArg();
+    return recv_ptr - recv_buf < recv_buf_sz && *recv_ptr && *recv_ptr != '\n';
+  }
+
+  //binary mode: receive the checksum of the packet of a streaming command after discarding any of its remaining payload
+  //bytes, and fail BAD_PACKET if it does not match; the handler must call this after receiving its arguments and before
+  //committing to any side effects, and abort if it fails; noop in text mode and for commands that are not streaming,
+  //whose checksum was already verified before their handler was run, see setStreaming()
+  ArduMon& recvChecksum() {
+    if ((!binary_mode && with_text) || !(flags&F_STREAMING) || hasErr()) return *this;
+    for (; stream_left > 0; --stream_left) if (streamByte() < 0) return *this;
+    if (streamByte() < 0) return *this;
+    flags &= ~F_STREAMING;
+    recv_ptr = recv_end; //nothing more to receive
+    return stream_sum ? fail(Error::BAD_PACKET) : *this;
+  }
+
   //skip the next n tokens in text mode; skip the next n bytes in binary mode
   ArduMon& skip(const uint8_t n = 1) { nextTok(n); return *this; }
 
@@ -437,6 +876,23 @@ public:
   ArduMon& recv(float &v) { return parseFloat(nextTok(4), &v); }
   ArduMon& recv(double &v) { return parseFloat(nextTok(sizeof(double)), &v); }
 
+  //binary mode: receive a command code, one byte, or if with_code16 one or two bytes, see sendCode()
+  //text mode: receive a decimal or hexadecimal command code
+  //BAD_ARG if the received code is greater than MAX_CMD_CODE
+  //this receives a code from the payload; a handler gets the code of its own command from getCodePath()
+  ArduMon& recvCode(cmd_code_t &v) {
+    uint16_t c = 0;
+    if (!binary_mode) { if (!recv(c)) return *this; }
+    else {
+      uint8_t b; if (!recv(b)) return *this;
+      c = b;
+      if (with_code16 && (b&0x80)) { if (!recv(b)) return *this; c = ((c&0x7f) << 8) | b; }
+    }
+    if (c > MAX_CMD_CODE) return fail(Error::BAD_ARG);
+    v = static_cast<cmd_code_t>(c);
+    return *this;
+  }
+
   //noop in binary mode
   //in text mode send carriage return and line feed instead of pending space separator
   //if force=true then always send CRLF; otherwise only send if a space separator is pending
@@ -514,6 +970,22 @@ public:
   ArduMon& sendRaw(const uint64_t v, const uint8_t fmt = 0) { return writeInt(BP(&v), false, 8, fmt); }
   ArduMon& sendRaw(const  int64_t v, const uint8_t fmt = 0) { return writeInt(BP(&v), true,  8, fmt); }
 
+  //binary mode: send a command code, typically the first payload byte(s) of a packet
+  //if with_code16 then codes below 0x80 are sent as one byte and others as two bytes, big endian with the high bit set
+  //for a subcommand send the group code(s) first, e.g. sendCode(motor_code).sendCode(set_code)
+  //text mode: send space separator if necessary, then send the code in decimal
+  ArduMon& sendCode(const cmd_code_t code) {
+    if (!binary_mode) return send(code);
+    if (!with_code16 || code < 0x80) return send(static_cast<uint8_t>(code));
+    return send(static_cast<uint8_t>(0x80 | (code >> 8))).send(static_cast<uint8_t>(code));
+  }
+
+  //send each code of a command path, e.g. from getCodePath(), as with sendCode(code)
+  ArduMon& sendCode(const CodePath &path) {
+    for (uint8_t i = 0; i < path.n; i++) sendCode(path.code[i]);
+    return *this;
+  }
+
   //binary mode: send little-endian float or double bytes
   //text mode: send space separator if necessary, then send float or double as decimal or scientific
   //on AVR both double and float are 4 bytes by default; on other platforms double may be 8 bytes
@@ -623,6 +1095,9 @@ public:
   static int strcmp_PP(const FSH* a, const FSH* b) { return strcmp_PP(CCS(a), CCS(b)); }
 #endif
 
+  //the message sent by sendReady()
+  static const FSH *readyMsg() { return F("ready"); }
+
   //convert the low nybble of i to a hex char 0-9A-F
   static char toHex(const uint8_t i) { return (i&0x0f) < 10 ? ('0' + (i&0x0f)) : ('A' + ((i&0x0f) - 10)); }
 
@@ -665,14 +1140,37 @@ private:
     F_SPACE_PENDING      = 1 << 4, //a space should be sent before the next returned value in text mode
     F_ERROR_RUNNABLE     = 1 << 5, //error_handler is a runnable
     F_UNIV_RUNNABLE      = 1 << 6, //universal_handler is a runnable
-    F_FALLBACK_RUNNABLE  = 1 << 7  //fallback_handler is a runnable
+    F_FALLBACK_RUNNABLE  = 1 << 7, //fallback_handler is a runnable
+    F_COMPOUND           = 1 << 8, //running the subcommands of a compound command in binary mode
+    F_SUB_DONE           = 1 << 9, //the current subcommand of a compound command called endHandler()
+    F_ERR_RESPONSE       = 1 << 10, //send error response packets in binary mode, see setErrorResponse()
+    F_TXT_MARKER_PROGMEM = 1 << 11, //text mode end of response marker is in program memory on AVR
+    F_STREAMING          = 1 << 12, //rest of the line or packet of a streaming command is unread, see setStreaming()
+    F_TXT_TAGGED         = 1 << 13, //the current text mode command has a request tag, see getTextTag()
+    F_TXT_TAG_PENDING    = 1 << 14, //the request tag should be sent before the next character of the response
+    F_TXT_SCRIPTED       = 1 << 15  //echo and prompt are suppressed because the input looks scripted
   };
-  uint8_t flags = 0;
+  uint16_t flags = 0;
 
   const char *txt_prompt = 0; //prompt string in text mode, 0 if none
 
+  const char *txt_end_marker = 0; //end of response marker in text mode, 0 if none
+
+  uint16_t txt_tag = 0; //request tag of the current text mode command, valid iff F_TXT_TAGGED
+
+  CodePath code_path; //see getCodePath()
+
   millis_t recv_deadline = 0, recv_timeout_ms = 0; //receive timeout, disabled by default
 
+  unsigned long recv_last_us = 0, recv_gap_us = 0; //binary mode inter-byte gap timeout, disabled by default
+
+  //text mode automatic echo and prompt suppression, disabled by default, see setTextAutoQuiet()
+  //recv_last_us is then the time of the last received character
+  unsigned long txt_script_gap_us = 0; millis_t txt_idle_ms = 0;
+
+  cmd_code_t err_response_code = 0; uint8_t err_response_echo = 0; //see setErrorResponse()
+  Error err_response_pending = Error::NONE; //a receive error whose response waits for send_buf, see failRecv()
+
   uint8_t arg_count = 0;
 
   //unfortunately zero length arrays are technically not allowed
@@ -686,6 +1184,21 @@ private:
   //start of next read while handling command
   char *recv_ptr = recv_buf;
 
+  //end of the received payload while handling a command in binary mode, i.e. the checksum or the next subcommand
+  char *recv_end = recv_buf;
+
+  //while handling a streaming text command, the start of the current argument token, which follows the command token
+  //in recv_buf; 0 otherwise
+  char *stream_tok = 0;
+
+  //while F_STREAMING in binary mode, the number of payload bytes not yet received, not counting the checksum, and the
+  //8 bit sum of the bytes received so far
+  uint8_t stream_left = 0, stream_sum = 0;
+
+  //while handling a streaming binary command, its length and code bytes, which streamBin() may overwrite in recv_buf;
+  //stream_head[0] is 0 otherwise, see writeErrResponse()
+  char stream_head[3] = { 0, 0, 0 };
+
   //send_buf is only used in binary mode
   //send_read_ptr is the next unsent byte; sending is disabled iff send_read_ptr is 0
   //send_write_ptr is the next free spot; writing to send_buf is disabled if send_write_ptr is 0
@@ -695,40 +1208,148 @@ private:
   //block for up to this long in pump_send_buf() in binary mode
   millis_t send_wait_ms = 0;
 
+  TokenBucket send_rate; //see setSendRate()
+
   union { handler_t error_handler; Runnable* error_runnable; };
   union { handler_t universal_handler; Runnable* universal_runnable; };
   union { handler_t fallback_handler; Runnable* fallback_runnable; };
 
-  uint8_t n_cmds = 0;
-
   struct Cmd {
 
     const char *name, *description;
-    uint8_t code;
+    cmd_code_t code;
 
-    union { handler_t handler; Runnable* runnable; };
+    union { handler_t handler; Runnable* runnable; CmdTable* group; };
 
-    enum { F_PROGMEM = 1 << 0, F_RUNNABLE = 1 << 1 };
+    enum { F_PROGMEM = 1 << 0, F_RUNNABLE = 1 << 1, F_GROUP = 1 << 2, F_STREAM = 1 << 3 };
     uint8_t flags = 0;
 
-    const bool is(const char *n) { return (flags&F_PROGMEM ? strcmp_P(n, name) : strcmp(n, name)) == 0; }
-
-#ifdef ARDUINO
-    const bool is(const FSH *n) {
-      return (flags&F_PROGMEM ? ArduMon::strcmp_PP(name, CCS(n)) : strcmp_P(name, CCS(n))) == 0;
+    //check if name is exactly the len chars at n, which is in program memory iff n_progmem
+    bool is(const char *n, const uint16_t len, const bool n_progmem) const {
+      if (!name) return false;
+      for (uint16_t i = 0; i < len; i++) if (rd(name + i, flags&F_PROGMEM) != rd(n + i, n_progmem)) return false;
+      return rd(name + len, flags&F_PROGMEM) == 0;
     }
-#endif
 
-    const bool is(const uint8_t c) { return code == c; }
+    bool is(const cmd_code_t c) const { return code == c; }
+
+    bool is(const handler_t h) const { return !(flags&(F_RUNNABLE|F_GROUP)) && handler == h; }
+
+    bool is(Runnable* const r) const { return (flags&F_RUNNABLE) && runnable == r; }
+  };
+
+public:
 
-    const bool is(const handler_t h) { return !(flags&F_PROGMEM) && handler == h; }
+  //the top level commands, or the subcommands of a group
+  struct CmdTable {
+    CmdTable(Cmd * const c, const uint16_t m) : cmds(c), max(m) {}
+    CmdTable(const CmdTable&) = delete;
+    CmdTable& operator=(const CmdTable&) = delete;
+  private:
+    friend class ArduMon;
+    Cmd * const cmds;
+    const uint16_t max;
+    uint16_t n = 0;
+    template <typename T> Cmd *find(const T key) const {
+      for (uint16_t i = 0; i < n; i++) if (cmds[i].is(key)) return cmds + i;
+      return 0;
+    }
+    Cmd *find(const char *name, const uint16_t len, const bool progmem) const {
+      for (uint16_t i = 0; i < n; i++) if (cmds[i].is(name, len, progmem)) return cmds + i;
+      return 0;
+    }
+    void remove(Cmd * const cmd) {
+      if (!cmd) return;
+      for (Cmd *c = cmd + 1; c < cmds + n; c++) *(c - 1) = *c;
+      --n;
+    }
+  };
 
-    const bool is(Runnable* const r) { return (flags&F_PROGMEM) && runnable == r; }
+  template <uint16_t max_group_cmds> struct CmdGroup : public CmdTable {
+    CmdGroup() : CmdTable(storage, max_group_cmds) {}
+  private:
+    Cmd storage[max_group_cmds > 0 ? max_group_cmds : 1];
   };
 
-  Cmd cmds[max_num_cmds > 0 ? max_num_cmds : 1];
+private:
+
+  //sentinel passed to addCmdImpl() to use the next available code in the target table
+  static const uint16_t AUTO_CODE = 0xffff;
+
+  //the top level command table
+  CmdGroup<max_num_cmds> cmds;
+
+  ArduMon& fail(Error e) { if (err == Error::NONE) { err = e; stats.failed(); } return *this; }
 
-  ArduMon& fail(Error e) { if (err == Error::NONE) err = e; return *this; }
+  //fail with a receive error outside of any handler, and send an error response if enabled and nothing else is queued
+  //the partially received command is abandoned, so the error is raised only once, and the next byte starts a new one
+  ArduMon& failRecv(Error e) {
+    flags &= ~F_RECEIVING; recv_ptr = recv_buf;
+    if (!binary_mode && e == Error::RECV_OVERFLOW) flags |= F_STREAMING; //discard the rest of the line in updateImpl()
+    if (err != Error::NONE) return *this;
+    fail(e);
+    if (send_write_ptr == send_buf + 1 && writeErrResponse(e, false)) sendPacketImpl();
+    else if (binary_mode && (flags&F_ERR_RESPONSE)) err_response_pending = e; //see sendPendingErrResponse()
+    return *this;
+  }
+
+  //binary mode: send the error response that failRecv() deferred because send_buf was busy, once it's free
+  //only the latest such error is kept, so each abandoned packet gets at most one error response
+  void sendPendingErrResponse() {
+    if (err_response_pending == Error::NONE || (flags&F_HANDLING) || send_write_ptr != send_buf + 1) return;
+    if (writeErrResponse(err_response_pending, false)) sendPacketImpl();
+    err_response_pending = Error::NONE;
+  }
+
+  //binary mode: if e is an error and setErrorResponse() then replace anything in send_buf with an error response
+  //with_cmd includes the failed command code and echo bytes from recv_buf; returns true if the response was written
+  bool writeErrResponse(const Error e, const bool with_cmd) {
+    if (!binary_mode || !with_binary || !(flags&F_ERR_RESPONSE) || e == Error::NONE || !send_write_ptr) return false;
+    const Error was = err; err = Error::NONE; //so that the sends below are not noops
+    send_write_ptr = send_buf + 1;
+    sendCode(err_response_code).send(static_cast<uint8_t>(e));
+    if (with_cmd && stream_head[0]) { //the payload may be gone from recv_buf, so echo only the code
+      sendRaw(stream_head + 1, (with_code16 && (stream_head[1]&0x80)) ? 2 : 1);
+    } else if (with_cmd) {
+      const uint8_t n = static_cast<uint8_t>(recv_buf[0]) - 2; //don't include length or checksum
+      const uint8_t nb = (with_code16 && (recv_buf[1]&0x80)) ? 2 : 1;
+      if (n >= nb) sendRaw(recv_buf + 1, nb + (n - nb < err_response_echo ? n - nb : err_response_echo));
+    }
+    const bool ok = !hasErr();
+    if (!ok) send_write_ptr = send_buf + 1; //error response didn't fit, send nothing
+    err = was;
+    return ok;
+  }
+
+  //keeps Stats if enabled, otherwise all noops and no storage
+  template <bool enabled, typename D = void> struct StatsKeeper {
+    Stats s; unsigned long start_us = 0;
+    const Stats& get() { return s; }
+    void clear() { s = Stats(); }
+    void failed() { ++s.errors; }
+    void received(const uint16_t used) { ++s.recv_bytes; if (used > s.recv_high) s.recv_high = used; }
+    void sent() { ++s.send_bytes; }
+    void queued(const uint16_t len) { if (len > s.send_high) s.send_high = len; }
+    void dispatched() { ++s.cmds; }
+    void handling() { start_us = micros(); }
+    void handled() {
+      const uint32_t us = micros() - start_us;
+      s.handler_us += us;
+      if (us > s.handler_max_us) s.handler_max_us = us;
+    }
+  };
+  template <typename D> struct StatsKeeper<false, D> {
+    const Stats& get() { static const Stats none; return none; }
+    void clear() {}
+    void failed() {}
+    void received(const uint16_t) {}
+    void sent() {}
+    void queued(const uint16_t) {}
+    void dispatched() {}
+    void handling() {}
+    void handled() {}
+  };
+  StatsKeeper<with_stats> stats;
 
   handler_t getDefaultErrorHandlerImpl() {
     return [](ArduMon &am){
@@ -764,48 +1385,86 @@ private:
     return (flags&runnable_flag) ? runnable : 0;
   }
 
+  //func is a handler_t, Runnable*, or CmdTable*; code may be AUTO_CODE
   template <typename T>
-  ArduMon& addCmdImpl(const T func, const char *name, const uint8_t code, const char *desc, const bool progmem) {
-    if (n_cmds == max_num_cmds) return fail(Error::CMD_OVERFLOW);
-    for (uint8_t i = 0; i < n_cmds; i++) {
-      if (name && ((progmem && cmds[i].is(reinterpret_cast<const FSH*>(name))) || (!progmem && cmds[i].is(name)))) {
-        return fail(Error::CMD_OVERFLOW);
-      }
-      if (cmds[i].code == code) return fail(Error::CMD_OVERFLOW);
-    }
-    cmds[n_cmds].name = name;
-    cmds[n_cmds].description = desc;
-    cmds[n_cmds].code = code;
-    cmds[n_cmds].flags = progmem ? Cmd::F_PROGMEM : 0;
-    setFunc(cmds[n_cmds], func);
-    ++n_cmds;
+  ArduMon& addCmdImpl(const T func, const char *name, const uint16_t code, const char *desc, const bool progmem) {
+    const char * const full_name = name;
+    CmdTable * const table = name ? findTable(name, progmem) : &cmds; //advances name past any group prefixes
+    if (!table || table->n == table->max) return fail(Error::CMD_OVERFLOW);
+    uint8_t depth = 1;
+    for (const char *p = full_name; p != name; p++) if (rd(p, progmem) == '.') ++depth;
+    if (depth > MAX_CMD_DEPTH) return fail(Error::CMD_OVERFLOW);
+    const uint16_t c = code == AUTO_CODE ? table->n : code;
+    if (c > MAX_CMD_CODE || table->find(static_cast<cmd_code_t>(c))) return fail(Error::CMD_OVERFLOW);
+    if (name && table->find(name, segLen(name, progmem), progmem)) return fail(Error::CMD_OVERFLOW);
+    Cmd &cmd = table->cmds[table->n++];
+    cmd.name = name;
+    cmd.description = desc;
+    cmd.code = static_cast<cmd_code_t>(c);
+    cmd.flags = progmem ? Cmd::F_PROGMEM : 0;
+    setFunc(cmd, func);
     return *this;
   }
 
-  template <typename T> ArduMon& removeCmdImpl(T &key) {
-    for (uint8_t i = 0; i < n_cmds; i++) {
-      if (cmds[i].is(key)) {
-        for (i++; i < n_cmds; i++) cmds[i - 1] = cmds[i];
-        --n_cmds;
-        break;
-      }
-    }
+  //remove the top level command matching key, which is a code, handler_t, or Runnable*
+  template <typename T> ArduMon& removeCmdImpl(const T key) {
+    cmds.remove(cmds.find(key));
+    return *this;
+  }
+
+  ArduMon& removeCmdImpl(const char *name, const bool progmem) {
+    CmdTable * const table = findTable(name, progmem);
+    if (table) table->remove(table->find(name, segLen(name, progmem), progmem));
+    return *this;
+  }
+
+  ArduMon& setStreamingImpl(const char *name, const bool streaming, const bool progmem) {
+    CmdTable * const table = findTable(name, progmem);
+    Cmd * const cmd = table ? table->find(name, segLen(name, progmem), progmem) : 0;
+    if (!cmd || (cmd->flags&Cmd::F_GROUP)) return fail(Error::BAD_CMD);
+    if (streaming) cmd->flags |= Cmd::F_STREAM; else cmd->flags &= ~Cmd::F_STREAM;
     return *this;
   }
 
-  template <typename T> int16_t getCmdCodeImpl(const T *name) {
-    for (uint8_t i = 0; i < n_cmds; i++) if (cmds[i].is(name)) return cmds[i].code;
-    return -1;
+  int16_t getCmdCodeImpl(const char *name, const bool progmem) {
+    CmdTable * const table = findTable(name, progmem);
+    const Cmd * const cmd = table ? table->find(name, segLen(name, progmem), progmem) : 0;
+    return cmd ? cmd->code : -1;
   }
 
-  void setFunc(Cmd& cmd, const handler_t func) { cmd.handler = func; cmd.flags &= ~Cmd::F_RUNNABLE; }
+  //follow the dotted group prefixes of path starting from the top level command table
+  //return the table that should contain the last path segment and advance path to that segment
+  //return 0 if a prefix does not name a command group; if in_path then append the group codes to code_path
+  CmdTable *findTable(const char* &path, const bool progmem, const bool in_path = false) {
+    CmdTable *table = &cmds;
+    for (uint16_t len = segLen(path, progmem); rd(path + len, progmem) == '.'; len = segLen(path, progmem)) {
+      const Cmd * const group = table->find(path, len, progmem);
+      if (in_path) inPath(group);
+      if (!group || !(group->flags&Cmd::F_GROUP)) return 0;
+      table = group->group;
+      path += len + 1;
+    }
+    return table;
+  }
+
+  //length of the dotted name segment at s, up to but not including the next '.' or terminating null
+  static uint16_t segLen(const char *s, const bool progmem) {
+    uint16_t len = 0;
+    for (char c = rd(s, progmem); c && c != '.'; c = rd(s + ++len, progmem));
+    return len;
+  }
+
+  static char rd(const char *p, const bool progmem) { return progmem ? pgm_read_byte(p) : *p; }
+
+  void setFunc(Cmd& cmd, const handler_t func) { cmd.handler = func; }
   void setFunc(Cmd& cmd, Runnable* const func) { cmd.runnable = func; cmd.flags |= Cmd::F_RUNNABLE; }
+  void setFunc(Cmd& cmd, CmdTable* const func) { cmd.group = func; cmd.flags |= Cmd::F_GROUP; }
 
-  //does nothing in binary mode, if txt_prompt is null, or if currently handling
+  //does nothing in binary mode, if txt_prompt is null, if currently handling, or while the input looks scripted
   //otherwise sends optional CRLF followed by txt_prompt and a space
   //this cannot cause an ArduMon error
   ArduMon& sendTextPrompt(const bool with_crlf = false) {
-    if (!with_text || binary_mode || !txt_prompt || flags&F_HANDLING) return *this;
+    if (!with_text || binary_mode || !txt_prompt || (flags&(F_HANDLING | F_TXT_SCRIPTED))) return *this;
     if (with_crlf) writeChar('\r').writeChar('\n');  //writeChar() and writeStr() cannot error in text mode
     writeStr(txt_prompt, flags&F_TXT_PROMPT_PROGMEM).writeChar(' ');
     return *this;
@@ -822,24 +1481,36 @@ private:
   }
 
   //can't use std::function on AVR
-  template <typename T> bool dispatch(const T& pred) {
+  //find() returns the command to run, or 0 if none
+  //it may advance recv_ptr and decrement arg_count past the codes or tokens that selected a command group
+  template <typename T> bool dispatch(const T& find) {
 
+    stats.dispatched();
+
+    code_path.n = 0; //find() appends to it, see inPath()
     bool retval;
     if (invoke(universal_handler, universal_runnable, flags, F_UNIV_RUNNABLE, retval)) return retval;
 
-    for (uint8_t i = 0; i < n_cmds; i++) {
-      if (pred(cmds[i])) {
-        if (invoke(cmds[i].handler, cmds[i].runnable, cmds[i].flags, Cmd::F_RUNNABLE, retval)) return retval;
-        else return false;
-      }
-    }
+    char * const start = recv_ptr;
+    const uint8_t start_argc = arg_count;
+
+    const Cmd * const cmd = find();
+    if (cmd) return invoke(cmd->handler, cmd->runnable, cmd->flags, Cmd::F_RUNNABLE, retval) && retval;
+
+    recv_ptr = start; arg_count = start_argc; code_path.n = 0; //the fallback handler gets the whole command
 
     if (invoke(fallback_handler, fallback_runnable, flags, F_FALLBACK_RUNNABLE, retval)) return retval;
 
     return fail(Error::BAD_CMD).endHandlerImpl();
   }
 
-  bool invoke(const handler_t handler, Runnable * const runnable, const uint8_t flags, const uint8_t runnable_flag,
+  //append the code of cmd, if any, to code_path and return cmd; see dispatch() and getCodePath()
+  const Cmd *inPath(const Cmd * const cmd) {
+    if (cmd && code_path.n < MAX_CMD_DEPTH) code_path.code[code_path.n++] = cmd->code;
+    return cmd;
+  }
+
+  bool invoke(const handler_t handler, Runnable * const runnable, const uint16_t flags, const uint8_t runnable_flag,
               bool &retval) {
     if      ((flags&runnable_flag) && runnable) { retval = runnable->run(*this); return true; }
     else if (!(flags&runnable_flag) && handler) { retval = handler(*this); return true; }
@@ -848,53 +1519,153 @@ private:
 
   //upon call, recv_ptr is the last received byte, which should be the checksum
   //if the checksum is invalid then BAD_PACKET
-  //otherwise set recv_ptr = recv_buf + 1 and dispatch()
+  //otherwise set recv_ptr = recv_buf + 1 and dispatchBin()
   bool handleBinCommand() {
     const uint8_t len = static_cast<uint8_t>(recv_buf[0]);
-    uint8_t sum = 0; for (uint8_t i = 0; i < len; i++) sum += static_cast<uint8_t>(recv_buf[i]);
-    if (sum != 0) return fail(Error::BAD_PACKET);
+    if (sum8(recv_buf, len) != 0) return fail(Error::BAD_PACKET);
     recv_ptr = recv_buf + 1; //skip over length
+    recv_end = recv_buf + len - 1; //checksum
     arg_count = len - 2; //don't include length or checksum bytes, but include command code byte in arg count
-    return dispatch([&](Cmd& cmd){ return arg_count && cmd.code == recv_buf[1]; });
+    return dispatchBin();
+  }
+
+  //dispatch() the arg_count bytes at recv_ptr, which start with a command code, possibly preceded by group codes
+  //the handler of a subcommand or of a two byte command code is run with recv_ptr at the last byte of its code
+  bool dispatchBin() {
+    return dispatch([&]() -> const Cmd* {
+      const CmdTable *table = &cmds;
+      while (arg_count > 0) {
+        uint8_t nb = 1;
+        uint16_t code = static_cast<uint8_t>(recv_ptr[0]);
+        if (with_code16 && (code&0x80)) {
+          if (arg_count < 2) return 0;
+          nb = 2;
+          code = ((code&0x7f) << 8) | static_cast<uint8_t>(recv_ptr[1]);
+        }
+        const Cmd * const cmd = inPath(table->find(static_cast<cmd_code_t>(code)));
+        if (!cmd) return 0;
+        if (!(cmd->flags&Cmd::F_GROUP)) { recv_ptr += nb - 1; arg_count -= nb - 1; return cmd; }
+        recv_ptr += nb; arg_count -= nb;
+        table = cmd->group;
+      }
+      return 0;
+    });
   }
 
-  //upon call, recv_ptr is the last received character, which will be either '\r' or '\n'
-  //tokenize recv_buf, parsing quoted characters and strings with escapes, and discarding any line end comment
-  //ignore empty commands
-  //otherwise set recv_ptr = recv_buf and dispatch()
-  bool handleTextCommand() {
+  //total microseconds to call f() n times
+  template <typename F> static uint32_t timeUS(const uint16_t n, const F &f) {
+    const unsigned long start = micros();
+    for (uint16_t i = 0; i < n; i++) f();
+    return micros() - start;
+  }
 
-    const uint16_t len = recv_ptr - recv_buf + 1;
+  //see getBenchHandler(); the results of the timed paths are folded into sink so they are not optimized away
+  //in binary mode the int and float format paths write to send_buf, which is rewound after each iteration
+  bool bench(const uint16_t n, uint32_t *us) {
 
-    if (len <= 1) return endHandlerImpl(); //ignore empty command, e.g. if received just '\r' or '\n'
+    volatile uint8_t sink = 0;
+    const bool text = !binary_mode && with_text;
 
-    const bool save_cmd = (len + 1) <= recv_buf_sz/2; //save cmd to upper half of recv_buf if possible for history
-    if (save_cmd) recv_buf[recv_buf_sz/2] = '\n'; //saved command is signaled by recv_buf[recv_buf_sz/2] = '\n'
+    char buf[48];
+    for (uint8_t i = 0; i < 32; i++) buf[i] = i;
+    us[0] = timeUS(n, [&]() { sink ^= sum8(buf, 32); });
+
+    const Cmd * const last = cmds.n > 0 ? cmds.cmds + cmds.n - 1 : 0;
+    const bool last_progmem = last && (last->flags&Cmd::F_PROGMEM);
+    const uint16_t last_len = last && last->name ? segLen(last->name, last_progmem) : 0;
+    us[1] = !last ? 0 : timeUS(n, [&]() {
+      sink ^= (text && last->name ? cmds.find(last->name, last_len, last_progmem) : cmds.find(last->code)) != 0;
+    });
+
+    int32_t i32 = -1234567;
+    const char *i32_src = text ? "-1234567" : BP(&i32);
+    us[2] = timeUS(n, [&]() { int32_t v; parseInt(i32_src, BP(&v), true, 4, false); sink ^= v; });
+
+    char * const send_start = send_write_ptr;
+    us[3] = timeUS(n, [&]() {
+      if (text) { formatLong(BP(&i32), true, 4, buf); sink ^= buf[0]; }
+      else { writeInt(BP(&i32), true, 4, 0); send_write_ptr = send_start; }
+    });
+
+    us[4] = us[5] = 0;
+    if (with_float) {
+      float f = -1234.567f;
+      const char *f_src = text ? "-1234.567" : BP(&f);
+      us[4] = timeUS(n, [&]() { float v; parseFloat(f_src, &v); sink ^= static_cast<int8_t>(v); });
+      us[5] = timeUS(n, [&]() {
+        if (text) { formatFloat(f, false, -1, -1, buf); sink ^= buf[0]; }
+        else { writeFloat(f, false, -1, -1); send_write_ptr = send_start; }
+      });
+    }
+
+    static const char line[] = "em \"foo bar\" 'x' -12 3.5 # comment\n";
+    us[6] = timeUS(n, [&]() {
+      uint16_t j; memcpy(buf, line, sizeof(line)); sink ^= tokenize(buf, sizeof(line), 0, j);
+    });
+
+    return !hasErr();
+  }
+
+  //tokenize the len chars at buf in place, parsing quoted characters and strings with escapes, and discarding any line
+  //end comment; whitespace is replaced by 0s and j is set to the length of the tokenized text
+  //if save is not 0 then the original input is also copied there, with the comment and line end replaced by 0s
+  //returns false on unterminated or improperly escaped strings or characters
+  static bool tokenize(char * const buf, const uint16_t len, char * const save, uint16_t &j) {
 
+    j = 0;
     bool in_str = false, in_chr = false;
-    uint16_t j = 0; //write index
     for (uint16_t i = 0; i < len; i++, j++) {
 
-      char c = recv_buf[i];
+      //move runs of characters that have no special meaning to the tokenizer in bulk
+      const uint16_t k = scanSpecial(buf + i, buf + len, '"', '\'', '#', '\\') - buf;
+      if (k > i) {
+        if (save) memcpy(save + i, buf + i, k - i);
+        if (j != i) memmove(buf + j, buf + i, k - i);
+        j += k - i; i = k;
+        if (i == len) break;
+      }
+
+      char c = buf[i];
 
       const bool comment_start = !in_str && !in_chr && c == '#';
 
-      //copy original input to upper half of recv_buf as saved command
-      if (save_cmd) recv_buf[recv_buf_sz/2 + 1 + i] = (comment_start || c == '\n' || c == '\r')  ? 0 : c;
+      //copy original input to save, e.g. the upper half of recv_buf as saved command
+      if (save) save[i] = (comment_start || c == '\n' || c == '\r')  ? 0 : c;
 
       if ((in_str || in_chr) && c == '\\') {
-        if (i == len - 1) return fail(Error::PARSE_ERR);
-        c = unescape(recv_buf[++i]);
+        if (i == len - 1) return false;
+        c = unescape(buf[++i]);
       }
       else if (!in_chr && c == '"') { in_str = !in_str; c = 0; } //start/end of string
       else if (!in_str && c == '\'') { in_chr = !in_chr;  c = 0; } //start/end of char
       else if (!in_str && !in_chr && isspace(c)) c = 0; //split on whitespace including terminating '\r' or '\n'
 
       if (comment_start) break;
-      else recv_buf[j] = c;
+      else buf[j] = c;
     }
 
-    if (in_str || in_chr) return fail(Error::PARSE_ERR);
+    return !in_str && !in_chr;
+  }
+
+  //upon call, recv_ptr is the last received character, which will be either '\r' or '\n'
+  //tokenize recv_buf, parsing quoted characters and strings with escapes, and discarding any line end comment
+  //ignore empty commands
+  //otherwise set recv_ptr = recv_buf and dispatch()
+  bool handleTextCommand() {
+
+    const uint16_t len = recv_ptr - recv_buf + 1;
+
+    if (len <= 1) return endHandlerImpl(); //ignore empty command, e.g. if received just '\r' or '\n'
+
+    int32_t tag; //an optional leading request tag token is skipped below, after tokenize(), see getTextTag()
+    skipTextTag(recv_buf, recv_ptr + 1, tag);
+    setTextTag(tag); //so that also a PARSE_ERR is tagged
+
+    const bool save_cmd = (len + 1) <= recv_buf_sz/2; //save cmd to upper half of recv_buf if possible for history
+    if (save_cmd) recv_buf[recv_buf_sz/2] = '\n'; //saved command is signaled by recv_buf[recv_buf_sz/2] = '\n'
+
+    uint16_t j = 0; //write index
+    if (!tokenize(recv_buf, len, save_cmd ? recv_buf + recv_buf_sz/2 + 1 : 0, j)) return fail(Error::PARSE_ERR);
 
     //null terminate final command token and zero out rest of recv_buf
     //we will always write at least one 0 here because the command ended with '\r' or '\n'
@@ -909,6 +1680,13 @@ private:
       if (++recv_ptr == end) return endHandlerImpl(); //ignore empty command
     }
 
+    if (flags&F_TXT_TAGGED) { //skip the request tag token
+      while (*recv_ptr) ++recv_ptr;
+      while (*recv_ptr == 0) {
+        if (++recv_ptr == end) return endHandlerImpl(); //a tag alone is an empty command, but still gets tagged marker
+      }
+    }
+
     char * const tmp = recv_ptr;
     arg_count = 0;
     while (++recv_ptr <= end) { if ((recv_ptr == end || !(*recv_ptr)) && *(recv_ptr - 1)) ++arg_count; }
@@ -916,10 +1694,200 @@ private:
 
     //DEBUG for (uint16_t k = 0; k < recv_buf_sz; k++) std::cerr << "recv_buf[" << k << "]=" << +recv_buf[k] << "\n";
 
-    const char *cmd_name = CCS(nextTok(0));
     recv_ptr = tmp; //first token returned to command handler should be the command token itself
 
-    return dispatch([&](Cmd& cmd){ return cmd.is(cmd_name); });
+    //a subcommand is either a dotted token like "motor.set" or separate tokens like "motor set"
+    //in the latter case the handler is run with recv_ptr at the subcommand token
+    return dispatch([&]() -> const Cmd* {
+      const CmdTable *table = &cmds;
+      for (const char *seg = recv_ptr; ;) {
+        const uint16_t len = segLen(seg, false);
+        const Cmd * const cmd = inPath(table->find(seg, len, false));
+        if (!cmd) return 0;
+        if (!(cmd->flags&Cmd::F_GROUP)) return seg[len] ? 0 : cmd;
+        table = cmd->group;
+        if (seg[len]) seg += len + 1;
+        else if (arg_count < 2) return 0;
+        else { nextTok(0); --arg_count; seg = recv_ptr; }
+      }
+    });
+  }
+
+  //text mode: called when whitespace is received at recv_ptr; if that ends the first token of the line, and the token
+  //names a streaming command, then dispatch it right away and return true, see setStreaming()
+  bool dispatchStreaming() {
+    if (recv_ptr == recv_buf || isspace(recv_ptr[-1])) return false; //not the end of a token
+    if (!canStream() || ((flags&F_UNIV_RUNNABLE) ? universal_runnable != 0 : universal_handler != 0)) return false;
+    if ((recv_ptr - recv_buf) + 2 >= recv_buf_sz) return false; //no room for arguments
+
+    char *start = recv_ptr;
+    while (start > recv_buf && !isspace(start[-1])) --start;
+    int32_t tag; //the first token may be preceded by a request tag token, see getTextTag()
+    if (skipTextTag(recv_buf, start, tag) != start) return false; //not the first token
+
+    const char c = *recv_ptr;
+    *recv_ptr = 0; //terminate the command token
+    const char *name = start;
+    const CmdTable * const table = findTable(name, false);
+    const Cmd * const cmd = table ? table->find(name, segLen(name, false), false) : 0;
+    if (!cmd || !(cmd->flags&Cmd::F_STREAM)) { *recv_ptr = c; return false; }
+
+    if (echoing()) writeChar(c);
+    if (recv_ptr < recv_buf + recv_buf_sz/2) recv_buf[recv_buf_sz/2] = 0; //arguments may overwrite saved command
+
+    flags &= ~F_RECEIVING; flags |= F_HANDLING | F_STREAMING; stats.handling();
+    setTextTag(tag);
+    stream_tok = recv_ptr + 1;
+    recv_ptr = start;
+    arg_count = 1;
+    const auto find = [&]() -> const Cmd* { const char *n = start; findTable(n, false, true); return inPath(cmd); };
+    if (!dispatch(find)) fail(Error::BAD_HANDLER).endHandlerImpl();
+    return true;
+  }
+
+  //true if waiting for the input of a streaming command is bounded by a timeout, see setStreaming()
+  bool canStream() { return recv_timeout_ms > 0 || ((binary_mode || !with_text) && recv_gap_us > 0); }
+
+  //wait for the next byte of the line or packet of a streaming command and return it without consuming it
+  //returns -1 on RECV_TIMEOUT, which in binary mode also abandons the rest of the packet
+  int streamPeek() {
+    const bool binary = binary_mode || !with_text;
+    while (!stream->available()) { //!canStream() if the timeouts were disabled while the command was streaming
+      if (!canStream() || (recv_timeout_ms > 0 && millis() > recv_deadline) ||
+          (binary && recv_gap_us > 0 && micros() - recv_last_us > recv_gap_us)) {
+        if (binary) flags &= ~F_STREAMING;
+        fail(Error::RECV_TIMEOUT);
+        return -1;
+      }
+    }
+    return stream->peek();
+  }
+
+  bool echoing() { return (flags&F_TXT_ECHO) && !(flags&F_TXT_SCRIPTED); }
+
+  //text mode: called with each received character at recv_ptr while setTextAutoQuiet() is enabled
+  //the input looks scripted if the character is followed by more input already waiting, or if it arrived less than
+  //txt_script_gap_us after the previous one; line endings and the parts of an escape sequence are not considered
+  void detectScripted() {
+    const unsigned long now = micros();
+    const char c = *recv_ptr;
+    const bool esc = c == 27 || (recv_ptr > recv_buf && recv_ptr[-1] == 27) ||
+      (recv_ptr > recv_buf + 1 && recv_ptr[-2] == 27);
+    if (!esc && c != '\r' && c != '\n' && (stream->available() || now - recv_last_us < txt_script_gap_us)) {
+      flags |= F_TXT_SCRIPTED;
+    }
+    recv_last_us = now;
+  }
+
+  //text mode: consume the next character of the line of a streaming command, with echo if enabled
+  //used is the number of bytes of recv_buf in use
+  char streamRead(const char *used) {
+    const char c = static_cast<char>(stream->read());
+    stats.received(used - recv_buf);
+    if (echoing()) { //the echo is not part of the response, so it is not tagged, see getTextTag()
+      const uint16_t tag_pending = flags&F_TXT_TAG_PENDING;
+      flags &= ~F_TXT_TAG_PENDING;
+      if (c == '\r' || c == '\n') writeChar('\r').writeChar('\n');
+      else writeChar(c);
+      flags |= tag_pending;
+    }
+    return c;
+  }
+
+  //text mode: skip whitespace and any comment up to the next argument of a streaming command
+  //returns true if there is one, false at the end of the line or on RECV_TIMEOUT
+  bool streamArg() {
+    recv_deadline = millis() + recv_timeout_ms; //the receive timeout applies to each token
+    bool comment = false;
+    while (!hasErr() && (flags&F_STREAMING)) {
+      const int c = streamPeek();
+      if (c < 0) return false;
+      if (c == '\r' || c == '\n') { streamRead(stream_tok); flags &= ~F_STREAMING; }
+      else if (comment || c == '#') { streamRead(stream_tok); comment = true; }
+      else if (isspace(c) || c == '\b' || c == 0x7F) streamRead(stream_tok);
+      else return true;
+    }
+    return false;
+  }
+
+  //text mode: receive the next argument of a streaming command into stream_tok and return it, see nextTok()
+  //quotes and escapes are handled the same as for buffered commands in handleTextCommand()
+  const char *streamTok() {
+    if (!streamArg()) { fail(Error::RECV_UNDERFLOW); return 0; }
+    char *p = stream_tok;
+    bool in_str = false, in_chr = false;
+    for (;;) {
+      if ((p - recv_buf) + 1 >= recv_buf_sz) { fail(Error::RECV_OVERFLOW); return 0; } //leave room for null
+      const int c = streamPeek();
+      if (c < 0) return 0;
+      const bool quoted = in_str || in_chr;
+      if (c == '\r' || c == '\n') { if (quoted) { fail(Error::PARSE_ERR); return 0; } break; } //see streamArg()
+      if (!quoted && (isspace(c) || c == '#' || ((c == '"' || c == '\'') && p > stream_tok))) break; //end of token
+      streamRead(p);
+      if (quoted && c == '\\') {
+        const int e = streamPeek();
+        if (e < 0) return 0;
+        if (e == '\r' || e == '\n') { fail(Error::PARSE_ERR); return 0; }
+        const char u = unescape(streamRead(p)); *p++ = u;
+      }
+      else if (!in_chr && c == '"') { if (in_str) break; in_str = true; } //a closing quote also ends the token
+      else if (!in_str && c == '\'') { if (in_chr) break; in_chr = true; }
+      else *p++ = static_cast<char>(c);
+    }
+    *p = 0;
+    return stream_tok;
+  }
+
+  //binary mode: called when a code byte of a packet, which is not its last byte, is received at recv_ptr; if that
+  //completes the code of a top level streaming command then dispatch it right away and return true, see setStreaming()
+  bool dispatchBinStreaming() {
+    const uint8_t nb = recv_ptr - recv_buf; //number of code bytes received
+    uint16_t code = static_cast<uint8_t>(recv_buf[1]);
+    if (with_code16 && (code&0x80)) {
+      if (nb != 2) return false;
+      code = ((code&0x7f) << 8) | static_cast<uint8_t>(recv_buf[2]);
+    } else if (nb != 1) return false;
+    if (!canStream() || ((flags&F_UNIV_RUNNABLE) ? universal_runnable != 0 : universal_handler != 0)) return false;
+
+    const Cmd * const cmd = cmds.find(static_cast<cmd_code_t>(code));
+    if (!cmd || !(cmd->flags&Cmd::F_STREAM)) return false;
+
+    const uint8_t len = static_cast<uint8_t>(recv_buf[0]);
+    flags &= ~F_RECEIVING; flags |= F_HANDLING | F_STREAMING; stats.handling();
+    stream_sum = sum8(recv_buf, nb + 1);
+    memcpy(stream_head, recv_buf, nb + 1);
+    stream_left = len - nb - 2; //not counting the length, code, and checksum bytes
+    arg_count = len - nb - 1; //as in dispatchBin() the handler is run with recv_ptr at the last byte of its code
+    recv_end = recv_ptr + 1;
+    if (!dispatch([&]() -> const Cmd* { return inPath(cmd); })) fail(Error::BAD_HANDLER).endHandlerImpl();
+    return true;
+  }
+
+  //binary mode: receive the next byte of the packet of a streaming command; returns -1 on RECV_TIMEOUT
+  int streamByte() {
+    if (streamPeek() < 0) return -1;
+    const uint8_t b = static_cast<uint8_t>(stream->read());
+    stats.received(recv_end - recv_buf);
+    if (recv_gap_us > 0) recv_last_us = micros();
+    stream_sum += b;
+    return b;
+  }
+
+  //binary mode: ensure that the next n bytes of the packet of a streaming command, or if n is 0 then the bytes through
+  //the next null, are in recv_buf from recv_ptr to recv_end, receiving more if needed; any unconsumed bytes are first
+  //moved to the start of recv_buf, so the payload of a streaming command can be larger than recv_buf
+  //returns false on error; if the packet ends first then nextTok() will fail RECV_UNDERFLOW
+  bool streamBin(const uint8_t n) {
+    uint16_t have = recv_end - recv_ptr;
+    if (n > 0 ? have >= n : memchr(recv_ptr, 0, have) != 0) return true;
+    if (recv_ptr != recv_buf) { memmove(recv_buf, recv_ptr, have); recv_ptr = recv_buf; recv_end = recv_buf + have; }
+    while (stream_left > 0 && (n > 0 ? have < n : (have == 0 || recv_end[-1] != 0))) {
+      if (have == recv_buf_sz) { fail(Error::RECV_OVERFLOW); return false; }
+      const int b = streamByte();
+      if (b < 0) return false;
+      *recv_end++ = static_cast<char>(b); ++have; --stream_left;
+    }
+    return true;
   }
 
   //advance recv_ptr to the start of the next input token in text mode and return the current token
@@ -931,6 +1899,8 @@ private:
 
     if (hasErr()) return 0;
 
+    if ((binary_mode || !with_text) && (flags&F_STREAMING) && !streamBin(binary_bytes)) return 0;
+
 #define FAIL { fail(Error::RECV_UNDERFLOW); return 0; }
 
     //caution UB dragonnes https://pvs-studio.com/en/blog/posts/cpp/1199/
@@ -942,16 +1912,27 @@ private:
 
     if (binary_mode && binary_bytes > 0) {
 
-      //recv_buf[0] is the received packet length; can only receive up to one less than that
-      //because the last packet buyte is the checksum which can't itself be received
+      //recv_end is the checksum, which can't itself be received, or the start of the next compound subcommand
       //this test also ensures that the requested binary_bytes are available
-      if ((recv_ptr - recv_buf) + binary_bytes >= recv_buf[0]) FAIL;
+      if (recv_end - recv_ptr < binary_bytes) FAIL;
 
       recv_ptr += binary_bytes; //advance recv_ptr for next receive
 
-    } else { //!binary_mode || !binary_bytes
+    } else if (binary_mode) { //null terminated string, which must end before recv_end
 
-      if (!binary_mode && *ret == '\n') FAIL; //can't receive start of saved command
+      if (recv_ptr >= recv_end) FAIL;
+      while (*recv_ptr) if (++recv_ptr == recv_end) FAIL;
+
+      ++recv_ptr; //skip only the terminating null, the following bytes may be zero valued data
+
+    } else if (stream_tok) { //streaming text command, see setStreaming()
+
+      if (recv_ptr >= stream_tok) return streamTok();
+      recv_ptr = stream_tok; //received the command token, the arguments follow in the stream
+
+    } else { //text mode
+
+      if (*ret == '\n') FAIL; //can't receive start of saved command
 
       //skip non-null characters of current token, but there needs to be at least one null after it
       while (*recv_ptr) if (++recv_ptr - recv_buf == recv_buf_sz) FAIL;
@@ -1246,27 +2227,9 @@ private:
     //but that increases progmem usage, probably not worth it
 
     if (num_bytes <= sizeof(long) || sizeof(long) <= max_bytes) {
-      constexpr uint8_t buf_sz = 2 + (sizeof(long) > 4 ? 20 : 10);
-      char buf[buf_sz];
-      if (sgnd) {
-        //sign extend: if sign bit (high bit of high byte) is set initialize to -1 which is all 1s in binary, else 0
-        long i = v[num_bytes-1]&0x80 ? -1 : 0;
-        memcpy(&i, v, num_bytes);
-#ifdef ARDUINO
-        ltoa(i, buf, 10);
-#else
-        snprintf(buf, sizeof(buf), "%ld", i);
-#endif
-      } else {
-        unsigned long i = 0;
-        memcpy(&i, v, num_bytes);
-#ifdef ARDUINO
-        ultoa(i, buf, 10);
-#else
-        snprintf(buf, sizeof(buf), "%lu", i);
-#endif
-      }
-      pad(buf, buf_sz, fmt);
+      char buf[long_buf_sz];
+      formatLong(v, sgnd, num_bytes, buf);
+      pad(buf, long_buf_sz, fmt);
       return writeStr(buf);
     }
 
@@ -1279,6 +2242,30 @@ private:
     return fail(Error::UNSUPPORTED);
   }
 
+  static constexpr uint8_t long_buf_sz = 2 + (sizeof(long) > 4 ? 20 : 10);
+
+  //format num_bytes <= sizeof(long) int starting at v as a null terminated decimal string in buf of long_buf_sz
+  static void formatLong(const char *v, const bool sgnd, const uint8_t num_bytes, char *buf) {
+    if (sgnd) {
+      //sign extend: if sign bit (high bit of high byte) is set initialize to -1 which is all 1s in binary, else 0
+      long i = v[num_bytes-1]&0x80 ? -1 : 0;
+      memcpy(&i, v, num_bytes);
+#ifdef ARDUINO
+      ltoa(i, buf, 10);
+#else
+      snprintf(buf, long_buf_sz, "%ld", i);
+#endif
+    } else {
+      unsigned long i = 0;
+      memcpy(&i, v, num_bytes);
+#ifdef ARDUINO
+      ultoa(i, buf, 10);
+#else
+      snprintf(buf, long_buf_sz, "%lu", i);
+#endif
+    }
+  }
+
   template <typename big_uint> //supports uint32_t, uint64_t
   ArduMon& writeDec(const char *v, const bool sgnd, const uint8_t num_bytes, const uint8_t fmt) {
     if (binary_mode || !with_text ||
@@ -1368,6 +2355,21 @@ private:
       return *this;
     }
 
+    char buf[float_buf_sz];
+    formatFloat(v, scientific, precision, width, buf);
+    return writeStr(buf);
+  }
+
+  //large enough for the scientific format, which is longer than the decimal format, see formatFloat()
+  static constexpr uint8_t float_buf_sz = 1 + 1 + 1 + ((with_double ? 16 : 8)-1) + 1 + 1 + (with_double ? 4 : 3) + 1;
+
+  //format float or double v into buf of float_buf_sz as a null terminated decimal or scientific number
+  //T must not be larger than the floats supported by this instance, see writeFloat()
+  template <typename T> //supports float and double
+  static void formatFloat(const T v, const bool scientific, const int8_t precision, const int8_t width, char *buf) {
+
+    constexpr uint8_t nb = with_double ? sizeof(T) : sizeof(float); //4 or 8
+
     constexpr uint8_t sig_dig = nb == 4 ? 8 : 16;
     constexpr uint8_t exp_dig = nb == 4 ? 3 : 4;
     const int8_t prec = precision < 0 || precision >= sig_dig ? sig_dig - 1 : precision;
@@ -1375,7 +2377,6 @@ private:
     if (scientific) {
       constexpr uint8_t buf_sz =
         1 + 1 + 1 + (sig_dig-1) + 1 + 1 + exp_dig + 1; //sign d . d{sig_dig-1} E sign d{exp_dig} \0
-      char buf[buf_sz];
       for (uint8_t i = 0; i < buf_sz; i++) buf[i] = 0;
 #ifdef __AVR__
       dtostre(v, buf, prec, DTOSTR_UPPERCASE); //dtostre() is only on AVR, not ESP32
@@ -1390,10 +2391,8 @@ private:
         while (buf[j]) buf[++k] = buf[j++];
         buf[++k] = 0;
       }
-      return writeStr(buf, false, false, -1);
     } else {
       constexpr uint8_t buf_sz = 1 + sig_dig + 1 + 1; //sign d{n} . d{sig_dig - n} \0
-      char buf[buf_sz];
       for (uint8_t i = 0; i < buf_sz; i++) buf[i] = 0;
       const int8_t wid = width < 0 ? -(buf_sz - 1) : //negative width = left align
         width >= buf_sz ? buf_sz - 1 : width;
@@ -1405,7 +2404,6 @@ private:
       snprintf(buf, buf_sz, fmt, v);
 #endif
       if (precision < 0) trimBackwards(buf, buf_sz - 1);
-      return writeStr(buf);
     }
   }
 
@@ -1445,16 +2443,28 @@ private:
 
     if (!v || hasErr() || len == 0) return *this;
 
+    //cooking only applies in text mode, where the string is quoted iff it contains whitespace or a char to escape
+    const bool cooked = !binary_mode && cook && len < 0;
+
     bool quote = false;
-    uint16_t n = 0, n_esc = 0;
-    while (len < 0 && v[n]) {
-      if (!binary_mode && cook && escape(v[n], '"')) { ++n_esc; quote = true; }
-      else if (!binary_mode && cook && isspace(v[n])) quote = true;
-      ++n;
+    uint16_t n = 0;
+    if (len < 0 && progmem) while (pgm_read_byte(v + n)) ++n;
+    else if (len < 0) n = strlen(v);
+    if (cooked && progmem) {
+      for (uint16_t i = 0; i < n && !quote; i++) quote = needsQuote(pgm_read_byte(v + i));
+    } else if (cooked) {
+      for (const char *p = v, *e = v + n; !quote && (p = scanSpecial(p, e, '"', '\\', 127, 127)) < e; ++p) {
+        quote = needsQuote(*p); //scanSpecial() may return false positives
+      }
     }
 
-    if (binary_mode && !checkWrite((len > 0) ? len : (n + n_esc + (quote ? 2 : 0) + 1))) {
-      return fail(Error::SEND_OVERFLOW);
+    if (binary_mode && !checkWrite((len > 0) ? len : n + 1)) return fail(Error::SEND_OVERFLOW);
+
+    if (binary_mode && !progmem) { //copy in bulk, including terminating null iff len < 0
+      const uint16_t nb = len > 0 ? len : n + 1;
+      memcpy(send_write_ptr, v, nb);
+      send_write_ptr += nb;
+      return *this;
     }
 
     char * const write_start = send_write_ptr;
@@ -1463,7 +2473,7 @@ private:
 
     for (uint16_t i = 0; len < 0 || i < len; i++) {
       const char c = progmem ? pgm_read_byte(v + i) : v[i];
-      const char esc = (c && !binary_mode && cook && len < 0) ? escape(c, '"') : 0;
+      const char esc = (c && cooked) ? escape(c, '"') : 0;
       if (esc) { put('\\'); put(esc); } else if (c || binary_mode) put(c);
       if (len < 0 && !c) break; //wrote terminating null
     }
@@ -1495,14 +2505,50 @@ private:
   //(send_read_ptr is updated in the write(...) functions which call this)
   //assumes checkWrite() already returned true
   void put(const char c) {
-    if (binary_mode || !with_text) *send_write_ptr++ = c;
-    else stream->write(c);
+    if (binary_mode || !with_text) { *send_write_ptr++ = c; return; }
+    if (flags&F_TXT_TAG_PENDING) writeTextTag();
+    stream->write(c); stats.sent();
+    if (c == '\n' && (flags&F_TXT_TAGGED)) flags |= F_TXT_TAG_PENDING; //tag the next response line, if any
+  }
+
+  //text mode: send the request tag of the current command, e.g. "@17 ", see getTextTag()
+  void writeTextTag() {
+    flags &= ~F_TXT_TAG_PENDING;
+    char buf[7]; uint8_t i = sizeof(buf); //'@', up to 5 digits, ' '
+    buf[--i] = ' ';
+    uint16_t v = txt_tag;
+    do { buf[--i] = '0' + v%10; v /= 10; } while (v);
+    buf[--i] = '@';
+    while (i < sizeof(buf)) put(buf[i++]);
+  }
+
+  //text mode: skip leading blanks and then an optional request tag token like "@17" and the blanks after it
+  //the tag must be followed by whitespace before end; returns the first character after the skipped ones
+  //tag is set to the value of the tag, or to -1 if there is none
+  static char *skipTextTag(char *p, const char *end, int32_t &tag) {
+    tag = -1;
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    if (p == end || *p != '@') return p;
+    char *q = p + 1;
+    uint32_t v = 0;
+    while (q < end && isdigit(*q) && v <= 0xffff) v = 10*v + (*q++ - '0');
+    if (q == p + 1 || v > 0xffff || q == end || !isspace(*q)) return p; //not a tag
+    while (q < end && (*q == ' ' || *q == '\t')) ++q;
+    tag = static_cast<int32_t>(v);
+    return q;
+  }
+
+  //text mode: start tagging the response to the current command with tag, if it is not -1
+  void setTextTag(const int32_t tag) {
+    if (tag < 0) return;
+    txt_tag = static_cast<uint16_t>(tag);
+    flags |= F_TXT_TAGGED | F_TXT_TAG_PENDING;
   }
 
   //see getSendBufUsed()
   uint16_t sendBufUsed() {
     if (!binary_mode || !with_binary) return 0;
-    return send_read_ptr ? send_buf[0] : (send_write_ptr - send_buf) + 1; //+1 for checksum
+    return send_read_ptr ? static_cast<uint8_t>(send_buf[0]) : (send_write_ptr - send_buf) + 1; //+1 for checksum
   }
 
   //see getRecvBufUsed()
@@ -1520,26 +2566,47 @@ private:
     if ((binary && !with_binary) || (!binary && !with_text)) return fail(Error::UNSUPPORTED);
     if (!force && binary_mode == binary) return *this;
     binary_mode = binary;
-    flags &= ~(F_SPACE_PENDING | F_HANDLING | F_RECEIVING);
+    flags &= ~(F_SPACE_PENDING | F_HANDLING | F_RECEIVING | F_STREAMING | F_TXT_TAGGED | F_TXT_TAG_PENDING |
+               F_TXT_SCRIPTED);
     recv_ptr = recv_buf;
+    stream_tok = 0;
     send_read_ptr = 0;
     arg_count = 0;
-    err = Error::NONE;
+    err = Error::NONE; err_response_pending = Error::NONE;
     if (binary_mode || !with_text) send_write_ptr = send_buf + 1; //enable writing send buf, first byte for length
     else { send_write_ptr = send_buf; sendTextPrompt(with_crlf); }
     return *this;
   }
 
   //see update()
-  ArduMon& updateImpl() {
+  ArduMon& updateImpl(const uint16_t max_recv_bytes) {
 
-    if ((flags&F_RECEIVING) && recv_timeout_ms > 0 && millis() > recv_deadline) fail(Error::RECV_TIMEOUT);
+    if ((flags&F_RECEIVING) && recv_timeout_ms > 0 && millis() > recv_deadline) failRecv(Error::RECV_TIMEOUT);
 
-    while (!hasErr() && !(flags&F_HANDLING) && stream->available()) { //pump receive buffer
+    if ((flags&F_RECEIVING) && recv_gap_us > 0 && binary_mode && !stream->available() &&
+        micros() - recv_last_us > recv_gap_us) failRecv(Error::RECV_TIMEOUT);
 
-      if (recv_ptr - recv_buf >= recv_buf_sz) { fail(Error::RECV_OVERFLOW); break; }
+    if ((flags&F_TXT_SCRIPTED) && !(flags&(F_RECEIVING | F_HANDLING)) && !stream->available() &&
+        micros() - recv_last_us > txt_idle_ms * 1000UL) { //input went idle, see setTextAutoQuiet()
+      flags &= ~F_TXT_SCRIPTED;
+      sendTextPrompt();
+    }
+
+    uint16_t num_recv = 0;
+    while (!hasErr() && !(flags&F_HANDLING) && stream->available() && !deferDispatch() &&
+           (max_recv_bytes == 0 || num_recv++ < max_recv_bytes)) { //pump receive buffer
+
+      if (flags&F_STREAMING) { //discard the unread rest of the line or packet of a streaming command, or of a line
+                               //that overflowed recv_buf
+        const char c = static_cast<char>(stream->read());
+        if ((binary_mode || !with_text) ? stream_left-- == 0 : (c == '\r' || c == '\n')) flags &= ~F_STREAMING;
+        continue;
+      }
+
+      if (recv_ptr - recv_buf >= recv_buf_sz) { failRecv(Error::RECV_OVERFLOW); break; }
       
       *recv_ptr = static_cast<char>(stream->read());
+      stats.received((recv_ptr - recv_buf) + 1);
       
       if (recv_ptr == recv_buf) { //received first command byte
         flags |= F_RECEIVING;
@@ -1547,25 +2614,30 @@ private:
       }
 
       if (binary_mode || !with_text) {
+
+        if (recv_gap_us > 0) recv_last_us = micros();
         
         if (recv_ptr == recv_buf) { //received length
-          if (*recv_ptr < 2) fail(Error::BAD_PACKET);
+          if (static_cast<uint8_t>(*recv_ptr) < 2) failRecv(Error::BAD_PACKET);
           else ++recv_ptr;
-        } else if ((recv_ptr - recv_buf) + 1 == recv_buf[0]) { //received full packet
-          flags &= ~F_RECEIVING; flags |= F_HANDLING;
+        } else if ((recv_ptr - recv_buf) + 1 == static_cast<uint8_t>(recv_buf[0])) { //received full packet
+          flags &= ~F_RECEIVING; flags |= F_HANDLING; stats.handling();
           if (!handleBinCommand()) fail(Error::BAD_HANDLER).endHandlerImpl();
           break; //handle at most one command per update()
-        } else ++recv_ptr;
+        } else if (dispatchBinStreaming()) break; //handle at most one command per update()
+        else ++recv_ptr;
 
         continue;
       }
 
       //text mode
 
+      if (txt_idle_ms > 0) detectScripted();
+
       if (*recv_ptr == '\r' || *recv_ptr == '\n') { //text mode end of command
         //interactive terminal programs like minicom will send '\r'
         //but if we only echo that, then the cursor will not advance to the next line
-        if (flags&F_TXT_ECHO) { writeChar('\r'); writeChar('\n'); } //ignore echo errors
+        if (echoing()) { writeChar('\r'); writeChar('\n'); } //ignore echo errors
         //we also want to handle cases where automation is sending commands e.g. from a script or canned text file
         //in that situation the newline could be platform dependent, e.g. '\n' on Unix and OS X, "\r\n" on Windows
         //if we receive "\r\n" that will just incur an extra empty command
@@ -1575,14 +2647,16 @@ private:
         //command will fill the Arduino serial receive buffer, which is typically 64 bytes.  So e.g. at 115200 8N1 a
         //each command handler has about 5ms to complete before the next command will overflow the receive buffer if
         //a script is being piped into the serial port.)
-        flags &= ~F_RECEIVING; flags |= F_HANDLING;
+        flags &= ~F_RECEIVING; flags |= F_HANDLING; stats.handling();
         if (!handleTextCommand()) fail(Error::BAD_HANDLER).endHandlerImpl();
         break; //handle at most one command per update() 
       }
 
+      if ((*recv_ptr == ' ' || *recv_ptr == '\t') && dispatchStreaming()) break; //handle at most one command
+
       if (*recv_ptr == '\b' || *recv_ptr == 0x7F) { //text mode backspace or DEL
         if (recv_ptr > recv_buf) {
-          if (flags&F_TXT_ECHO) { vt100MoveRel(1, VT100_LEFT); vt100ClearRight(); }
+          if (echoing()) { vt100MoveRel(1, VT100_LEFT); vt100ClearRight(); }
           --recv_ptr;
         }
         continue;
@@ -1604,7 +2678,7 @@ private:
       
       bool esc_seq_pending = *recv_ptr == 27 || (*recv_ptr == '[' && recv_ptr > recv_buf && *(recv_ptr-1) == 27);
       
-      if ((flags&F_TXT_ECHO) && !(esc_seq_end || esc_seq_pending)) writeChar(*recv_ptr);
+      if (echoing() && !(esc_seq_end || esc_seq_pending)) writeChar(*recv_ptr);
       
       if (!esc_seq_end) ++recv_ptr; //common case
       else if (*recv_ptr == 'A' && (recv_ptr - recv_buf) < recv_buf_sz/2 && recv_buf[recv_buf_sz/2] == '\n') {
@@ -1621,20 +2695,37 @@ private:
     } //pump receive buffer
 
     //RECV_OVERFLOW, RECV_TIMEOUT, BAD_CMD, BAD_PACKET, PARSE_ERR, UNSUPPORTED
-    if (!isHandling() && hasErr() && handleErrImpl()) endHandlerImpl().sendTextPrompt();
+    const bool recv_err = err == Error::RECV_OVERFLOW || err == Error::RECV_TIMEOUT;
+    if (!isHandling() && hasErr() && handleErrImpl()) {
+      endHandlerImpl();
+      //a command that failed to be received also gets an end of response marker, see setTextEndMarker()
+      if (recv_err && !binary_mode && with_text && txt_end_marker) writeStr(txt_end_marker, flags&F_TXT_MARKER_PROGMEM);
+      sendTextPrompt();
+    }
 
-    if (binary_mode) pumpSendBuf(0);
+    if (binary_mode) { sendPendingErrResponse(); pumpSendBuf(0); }
 
     return *this;
   }
 
+  //binary mode: true if the next received byte could dispatch a command, i.e. it is the last byte or a code byte of a
+  //packet, while send_buf still holds a packet, e.g. one held back by setSendRate(); the response of the command would
+  //then fail SEND_OVERFLOW, so the byte is left in the stream until the packet is sent
+  bool deferDispatch() {
+    if (!binary_mode || !with_binary || send_write_ptr || recv_ptr == recv_buf || (flags&F_STREAMING)) return false;
+    const uint8_t n = recv_ptr - recv_buf; //number of bytes received so far
+    return n + 1 == static_cast<uint8_t>(recv_buf[0]) || n <= 2;
+  }
+
   void pumpSendBuf(const millis_t wait_ms) {
     if (!binary_mode || !with_binary) return;
     const millis_t deadline = millis() + wait_ms;
     do {
-      while (send_read_ptr != 0 && stream->availableForWrite()) {
+      while (send_read_ptr != 0 && stream->availableForWrite() &&
+             (send_read_ptr != send_buf || send_rate.take(static_cast<uint8_t>(send_buf[0])))) {
         stream->write(*send_read_ptr++);
-        if (send_read_ptr - send_buf == send_buf[0]) { //sent entire packet
+        stats.sent();
+        if (send_read_ptr - send_buf == static_cast<uint8_t>(send_buf[0])) { //sent entire packet
           send_read_ptr = 0; //disable reading from send buf
           send_write_ptr = send_buf + 1; //enable writing to send buf, reserve first byte for length
         }
@@ -1646,6 +2737,59 @@ private:
 
   void pumpSendBuf() { pumpSendBuf(send_wait_ms); }
 
+  //see getCompoundHandler()
+  bool handleCompound() {
+
+    if (!binary_mode || !with_binary || (flags&F_COMPOUND)) return fail(Error::UNSUPPORTED).endHandlerImpl();
+
+    uint8_t opts;
+    if (!skip().recv(opts)) return endHandlerImpl();
+
+    //check framing before running any subcommands
+    char * const first = recv_ptr, * const end = recv_end;
+    for (char *p = first; p < end; p += 1 + static_cast<uint8_t>(*p)) {
+      if (end - (p + 1) < static_cast<uint8_t>(*p)) return fail(Error::BAD_PACKET).endHandlerImpl();
+    }
+
+    if (!checkWrite(1)) return fail(Error::SEND_OVERFLOW).endHandlerImpl();
+    char * const num_records = send_write_ptr;
+    put(0);
+
+    flags |= F_COMPOUND;
+
+    uint8_t n = 0;
+    for (char *p = first; p < end; ++n) {
+
+      if (!checkWrite(2)) { fail(Error::SEND_OVERFLOW); break; }
+      char * const record = send_write_ptr;
+      put(0); put(0); //data len and error, filled in below
+
+      arg_count = static_cast<uint8_t>(*p);
+      recv_ptr = p + 1;
+      p = recv_end = recv_ptr + arg_count;
+
+      flags &= ~F_SUB_DONE;
+      if (!dispatchBin()) fail(Error::BAD_HANDLER);
+      if (!(flags&F_SUB_DONE)) fail(Error::UNSUPPORTED); //didn't call endHandler(), i.e. tried to run async
+
+      const Error e = err;
+      if (e == Error::SEND_OVERFLOW || (opts&COMPOUND_NO_RESPONSE)) send_write_ptr = record + 2; //drop data, keep error
+      record[0] = static_cast<char>(send_write_ptr - (record + 2));
+      record[1] = static_cast<char>(e);
+      if (opts&COMPOUND_NO_RESPONSE) send_write_ptr = record;
+
+      err = Error::NONE; //reported in the record instead of to the error handler
+
+      if (e == Error::SEND_OVERFLOW || (e != Error::NONE && (opts&COMPOUND_STOP_ON_ERROR))) { ++n; break; }
+    }
+
+    flags &= ~(F_COMPOUND | F_SUB_DONE);
+    *num_records = static_cast<char>(n);
+    if (opts&COMPOUND_NO_RESPONSE) send_write_ptr = num_records; //empty packet, which endHandlerImpl() won't send
+
+    return endHandlerImpl();
+  }
+
   ArduMon& handleErrImpl() {
     if (err != Error::NONE &&
         ((flags&F_ERROR_RUNNABLE && error_runnable && error_runnable->run(*this)) ||
@@ -1658,8 +2802,14 @@ private:
   //see endHandler()
   ArduMon& endHandlerImpl() {
 
+    if (flags&F_COMPOUND) { flags |= F_SUB_DONE; return *this; } //end of compound subcommand, see handleCompound()
+
     const bool was_handling = flags&F_HANDLING; //tolerate being called when not actually handling
 
+    //a bad checksum means the command code can't be trusted
+    if (was_handling) writeErrResponse(err, err != Error::BAD_PACKET);
+    stream_head[0] = 0;
+
     //BAD_HANDLER, RECV_UNDERFLOW, BAD_ARG, SEND_OVERFLOW, UNSUPPORTED
     handleErrImpl();
 
@@ -1667,17 +2817,26 @@ private:
 
     flags &= ~(F_SPACE_PENDING | F_HANDLING);
     recv_ptr = recv_buf;
+    stream_tok = 0; //any unread rest of the line of a streaming command is discarded in updateImpl()
     arg_count = 0;
 
     if (!was_handling) return *this;
 
-    else if (!binary_mode || !with_binary) return sendTextPrompt();
+    stats.handled();
+
+    if (!binary_mode || !with_binary) {
+      if (with_text && txt_end_marker) writeStr(txt_end_marker, flags&F_TXT_MARKER_PROGMEM);
+      flags &= ~(F_TXT_TAGGED | F_TXT_TAG_PENDING);
+      return sendTextPrompt();
+    }
     else return sendPacketImpl();
   }
 
   ArduMon& sendPacketImpl() {
 
-    if (!binary_mode || !with_binary) return *this;
+    if (!binary_mode || !with_binary || (flags&F_COMPOUND)) return *this; //compound responses are sent all at once
+
+    if (!send_write_ptr) return *this; //the previous packet is still waiting to be sent, so nothing was written
 
     const uint16_t len = send_write_ptr - send_buf;
 
@@ -1688,8 +2847,8 @@ private:
 
     if (len > 1) { //ignore empty packet, but first byte of send_buf is reserved for length
       send_buf[0] = static_cast<uint8_t>(len + 1); //set packet length including checksum
-      uint8_t sum = 0; for (uint8_t i = 0; i < len; i++) sum += static_cast<uint8_t>(send_buf[i]);
-      send_buf[len] = static_cast<uint8_t>(-sum); //set packet checksum
+      stats.queued(len + 1);
+      send_buf[len] = static_cast<uint8_t>(-sum8(send_buf, len)); //set packet checksum
       send_write_ptr = 0; //disable writing to send buf
       send_read_ptr = send_buf; //enable reading from send buf
       pumpSendBuf();
@@ -1698,17 +2857,56 @@ private:
     return *this;
   }
 
-  ArduMon& sendCmdsImpl() {
+  //the chain of enclosing command groups while listing subcommands in sendCmdsImpl()
+  struct CmdPath { const Cmd *cmd; const CmdPath *up; };
+
+  ArduMon& sendCmdsImpl(const CmdTable &table, const CmdPath *up) {
     if (binary_mode || !with_text) return *this;
-    for (uint8_t i = 0; i < n_cmds; i++) { //sending cannot error in text mode
-      writeChar(toHex(cmds[i].code >> 4)).writeChar(toHex(cmds[i].code)).writeChar(' ');
-      if (cmds[i].name) writeStr(cmds[i].name, cmds[i].flags&Cmd::F_PROGMEM);
-      if (cmds[i].description) writeChar(' ').writeStr(cmds[i].description, cmds[i].flags&Cmd::F_PROGMEM);
+    for (uint16_t i = 0; i < table.n; i++) { //sending cannot error in text mode
+      const Cmd &cmd = table.cmds[i];
+      const CmdPath path = { &cmd, up };
+      writeCmdPath(&path, false).writeChar(' ');
+      if (cmd.name) writeCmdPath(&path, true);
+      if (cmd.description) writeChar(' ').writeStr(cmd.description, cmd.flags&Cmd::F_PROGMEM);
       sendCRLF(true);
+      if (cmd.flags&Cmd::F_GROUP) sendCmdsImpl(*cmd.group, &path);
     }
     return *this;
   }
 
+  //write the hex codes or the names of the commands on path separated by '.', outermost first
+  ArduMon& writeCmdPath(const CmdPath *path, const bool names) {
+    if (path->up) writeCmdPath(path->up, names).writeChar('.');
+    const Cmd &cmd = *(path->cmd);
+    if (names) return writeStr(cmd.name, cmd.flags&Cmd::F_PROGMEM);
+    if (with_code16) writeChar(toHex(cmd.code >> 12)).writeChar(toHex(cmd.code >> 8));
+    return writeChar(toHex(cmd.code >> 4)).writeChar(toHex(cmd.code));
+  }
+
+  uint32_t cmdHashImpl(const CmdTable &table, const CmdPath *up) {
+    uint32_t sum = 0;
+    for (uint16_t i = 0; i < table.n; i++) {
+      const Cmd &cmd = table.cmds[i];
+      const CmdPath path = { &cmd, up };
+      sum += hashCmdPath(&path, fnv1a(hashCmdPath(&path, FNV_BASIS, true), 0), false);
+      if (cmd.flags&Cmd::F_GROUP) sum += cmdHashImpl(*cmd.group, &path);
+    }
+    return sum;
+  }
+
+  //hash the names (separated by '.') or the codes of the commands on path, outermost first, see getCmdHash()
+  static uint32_t hashCmdPath(const CmdPath *path, uint32_t h, const bool names) {
+    if (path->up) { h = hashCmdPath(path->up, h, names); if (names) h = fnv1a(h, '.'); }
+    const Cmd &cmd = *(path->cmd);
+    if (!names) return fnv1a(fnv1a(h, static_cast<uint8_t>(cmd.code)), static_cast<uint8_t>(cmd.code >> 8));
+    const bool progmem = cmd.flags&Cmd::F_PROGMEM;
+    for (const char *c = cmd.name; c && rd(c, progmem); c++) h = fnv1a(h, static_cast<uint8_t>(rd(c, progmem)));
+    return h;
+  }
+
+  static const uint32_t FNV_BASIS = 2166136261UL;
+  static uint32_t fnv1a(const uint32_t h, const uint8_t b) { return (h ^ b) * 16777619UL; }
+
   char getKeyImpl() {
     if (!stream->available()) return 0;
     char c = static_cast<char>(stream->read());
@@ -1766,6 +2964,87 @@ private:
     }
   }
 
+  //true iff c needs to be quoted when sent cooked in text mode: whitespace or requires backslash escape
+  static bool needsQuote(const char c) { return isspace(c) || escape(c, '"'); }
+
+  //return pointer to the first char in [s, end) that is less than or equal to ' ' or equal to a, b, c, or d
+  //return end if there is no such char
+  //this covers whitespace and all control chars, so callers needing a narrower class can check and skip false positives
+  static const char *scanSpecial(const char *s, const char * const end,
+                                 const char a, const char b, const char c, const char d) {
+#if defined(ARDUMON_SSE2)
+    const __m128i sp = _mm_set1_epi8(' '), va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b);
+    const __m128i vc = _mm_set1_epi8(c), vd = _mm_set1_epi8(d);
+    for (; end - s >= 16; s += 16) {
+      const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+      __m128i m = _mm_cmpeq_epi8(_mm_min_epu8(x, sp), x); //unsigned x <= ' '
+      m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(x, va), _mm_cmpeq_epi8(x, vb)));
+      m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(x, vc), _mm_cmpeq_epi8(x, vd)));
+      const int mask = _mm_movemask_epi8(m);
+      if (mask) return s + __builtin_ctz(mask);
+    }
+#elif defined(ARDUMON_NEON)
+    const uint8x16_t sp = vdupq_n_u8(' '), va = vdupq_n_u8(a), vb = vdupq_n_u8(b);
+    const uint8x16_t vc = vdupq_n_u8(c), vd = vdupq_n_u8(d);
+    for (; end - s >= 16; s += 16) {
+      const uint8x16_t x = vld1q_u8(reinterpret_cast<const uint8_t*>(s));
+      uint8x16_t m = vcleq_u8(x, sp);
+      m = vorrq_u8(m, vorrq_u8(vceqq_u8(x, va), vceqq_u8(x, vb)));
+      m = vorrq_u8(m, vorrq_u8(vceqq_u8(x, vc), vceqq_u8(x, vd)));
+      if (vmaxvq_u8(m)) break; //find the exact position bytewise below
+    }
+#elif defined(ARDUMON_SWAR)
+    //see https://graphics.stanford.edu/~seander/bithacks.html#HasLessInWord
+    using word_t = uintptr_t;
+    constexpr word_t ones = ~static_cast<word_t>(0) / 255, highs = ones * 0x80;
+    const word_t wa = ones * static_cast<uint8_t>(a), wb = ones * static_cast<uint8_t>(b);
+    const word_t wc = ones * static_cast<uint8_t>(c), wd = ones * static_cast<uint8_t>(d);
+#define HAS_ZERO(x) (((x) - ones) & ~(x) & highs)
+    for (; end - s >= static_cast<ptrdiff_t>(sizeof(word_t)); s += sizeof(word_t)) {
+      word_t x; memcpy(&x, s, sizeof(word_t)); //compiles to a single (possibly unaligned) load
+      if (((x - ones * (' ' + 1)) & ~x & highs) || //some byte x <= ' '
+          HAS_ZERO(x ^ wa) || HAS_ZERO(x ^ wb) || HAS_ZERO(x ^ wc) || HAS_ZERO(x ^ wd)) break;
+    }
+#undef HAS_ZERO
+#endif
+    for (; s < end; ++s) {
+      const char x = *s;
+      if (static_cast<uint8_t>(x) <= ' ' || x == a || x == b || x == c || x == d) return s;
+    }
+    return end;
+  }
+
+  //8 bit unsigned sum of n bytes starting at p
+  static uint8_t sum8(const char *p, uint16_t n) {
+    uint8_t sum = 0;
+#if defined(ARDUMON_SSE2)
+    const __m128i zero = _mm_setzero_si128(); __m128i acc = zero;
+    for (; n >= 16; n -= 16, p += 16) {
+      acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), zero));
+    }
+    sum = static_cast<uint8_t>(_mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+#elif defined(ARDUMON_NEON)
+    uint16x8_t acc = vdupq_n_u16(0); //lanes may wrap, but that preserves the sum mod 256
+    for (; n >= 16; n -= 16, p += 16) acc = vpadalq_u8(acc, vld1q_u8(reinterpret_cast<const uint8_t*>(p)));
+    sum = static_cast<uint8_t>(vaddvq_u16(acc));
+#elif defined(ARDUMON_SWAR)
+    using word_t = uintptr_t;
+    constexpr word_t lo = ~static_cast<word_t>(0) / 0xFFFF * 0xFF; //0x00FF00FF...
+    while (n >= sizeof(word_t)) {
+      //accumulate pairs of bytes in 16 bit lanes, folding before a lane could carry into its neighbor
+      word_t acc = 0;
+      for (uint8_t i = 0; i < 128 && n >= sizeof(word_t); i++, n -= sizeof(word_t), p += sizeof(word_t)) {
+        word_t x; memcpy(&x, p, sizeof(word_t));
+        acc += (x & lo) + ((x >> 8) & lo);
+      }
+      for (uint8_t s = 16; s < 8 * sizeof(word_t); s += 16) sum += static_cast<uint8_t>(acc >> s);
+      sum += static_cast<uint8_t>(acc);
+    }
+#endif
+    for (; n > 0; n--) sum += static_cast<uint8_t>(*p++);
+    return sum;
+  }
+
   //convert escape chare to escape code, if any
   static const char unescape(const char c) {
     switch (c) {